@@ -0,0 +1,394 @@
+//----------------------------------------------------------------------------
+// Construction and serialization benchmarks for simple_html_writer.h.
+//
+// Run:     cmake --build <dir> --target benchmark
+//          simple_html_benchmark [name filter]
+// Output:  one JSON object per line and scenario, e.g.
+//          {"scenario":"table","parameters":"1000x10","nodes":11001,...}
+//          Serialization is measured with the default and the minified layout.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+// Every heap allocation in the process is counted. All forms of operator new
+// and delete are replaced, so each block is freed by the function that
+// matches the one it came from.
+static std::atomic<std::size_t> allocation_count{0};
+
+void*   CountedAllocate(std::size_t size)
+{
+    ++allocation_count;
+    if (void *p = std::malloc(size > 0 ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void*   operator new(std::size_t size)                      {return CountedAllocate(size);}
+void*   operator new[](std::size_t size)                    {return CountedAllocate(size);}
+void    operator delete(void *p) noexcept                   {std::free(p);}
+void    operator delete[](void *p) noexcept                 {std::free(p);}
+void    operator delete(void *p, std::size_t) noexcept      {std::free(p);}
+void    operator delete[](void *p, std::size_t) noexcept    {std::free(p);}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Scenario class describes one benchmark: how to build the tree and how many nodes it has.
+ */
+class   Scenario
+{
+public:
+    std::string name;
+    std::string parameters;
+    std::size_t nodes;
+    std::function<std::shared_ptr<NodeBase>()>  build;
+};
+
+//----------------------------------------------------------------------------
+using   Clock = std::chrono::steady_clock;
+
+double  Nanoseconds(Clock::time_point start, Clock::time_point stop)
+{
+    return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+//----------------------------------------------------------------------------
+void    Run(const Scenario &scenario)
+{
+    double  nodes = double(scenario.nodes);
+
+    std::size_t allocations = allocation_count;
+    auto        start = Clock::now();
+    auto        root = scenario.build();
+    auto        stop = Clock::now();
+    double      build_ns = Nanoseconds(start, stop);
+    std::size_t build_allocations = allocation_count - allocations;
+
+    int         repetitions = int(std::max<std::size_t>(3, std::min<std::size_t>(50, 4000000 / scenario.nodes)));
+    std::size_t bytes = 0;
+
+    allocations = allocation_count;
+    start = Clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        bytes = root->Get().size();
+    }
+    stop = Clock::now();
+    double      serialize_ns = Nanoseconds(start, stop) / repetitions;
+    double      serialize_allocations = double(allocation_count - allocations) / repetitions;
+
+    std::size_t minified_bytes = 0;
+
+    start = Clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        minified_bytes = root->Get(Layout::Minified()).size();
+    }
+    stop = Clock::now();
+    double      minified_ns = Nanoseconds(start, stop) / repetitions;
+
+    start = Clock::now();
+    root.reset();
+    stop = Clock::now();
+    double      destroy_ns = Nanoseconds(start, stop);
+
+    std::cout << "{\"scenario\":\"" << scenario.name << "\""
+              << ",\"parameters\":\"" << scenario.parameters << "\""
+              << ",\"nodes\":" << scenario.nodes
+              << ",\"output_bytes\":" << bytes
+              << ",\"build_ns_per_node\":" << build_ns / nodes
+              << ",\"build_allocations_per_node\":" << double(build_allocations) / nodes
+              << ",\"serialize_ns_per_node\":" << serialize_ns / nodes
+              << ",\"serialize_bytes_per_s\":" << double(bytes) / serialize_ns * 1e9
+              << ",\"serialize_allocations_per_node\":" << serialize_allocations / nodes
+              << ",\"minified_output_bytes\":" << minified_bytes
+              << ",\"minified_serialize_ns_per_node\":" << minified_ns / nodes
+              << ",\"destroy_ns_per_node\":" << destroy_ns / nodes
+              << "}" << std::endl;
+}
+
+//----------------------------------------------------------------------------
+Scenario    TableScenario(std::size_t rows, std::size_t columns)
+{
+    return {"table", std::to_string(rows) + "x" + std::to_string(columns), 1 + rows * (1 + columns), [=]()
+    {
+        auto    table = Get<Table>();
+
+        for (std::size_t r = 0; r < rows; ++r)
+        {
+            auto    row = table->AppendChild(Get<TableRow>());
+
+            for (std::size_t c = 0; c < columns; ++c)
+            {
+                row->AppendChild(Get<TableElement>(std::to_string(r * columns + c)));
+            }
+        }
+
+        return std::shared_ptr<NodeBase>(table);
+    }};
+}
+
+/// Same output shape as TableScenario, built from columns of numbers; nodes counts the cells.
+Scenario    ColumnTableScenario(std::size_t rows, std::size_t columns)
+{
+    return {"column_table", std::to_string(rows) + "x" + std::to_string(columns), 1 + rows * (1 + columns), [=]()
+    {
+        auto    table = Get<ColumnTable>();
+
+        for (std::size_t c = 0; c < columns; ++c)
+        {
+            std::vector<double> values(rows);
+
+            for (std::size_t r = 0; r < rows; ++r)
+            {
+                values[r] = double(r * columns + c) / 8;
+            }
+            table->AppendColumn("", std::move(values), NumberFormat{3}, "number");
+        }
+
+        return std::shared_ptr<NodeBase>(table);
+    }};
+}
+
+/// A table of a few repeated status texts; interned makes equal cells share one node.
+Scenario    StatusTableScenario(std::size_t rows, std::size_t columns, bool interned)
+{
+    return {interned ? "status_table_interned" : "status_table", std::to_string(rows) + "x" + std::to_string(columns), 1 + rows * (1 + columns), [=]()
+    {
+        static const char   *status[] = {"OK", "-", "0", "FAIL"};
+        NodeInterner        cells;
+        auto                table = Get<Table>();
+
+        for (std::size_t r = 0; r < rows; ++r)
+        {
+            auto    row = table->AppendChild(Get<TableRow>());
+
+            for (std::size_t c = 0; c < columns; ++c)
+            {
+                const char  *text = status[(r + c) % 4];
+
+                if (interned)
+                {
+                    row->AppendChild(cells.Get<TableElement>(text));
+                }
+                else
+                {
+                    row->AppendChild(Get<TableElement>(text));
+                }
+            }
+        }
+
+        return std::shared_ptr<NodeBase>(table);
+    }};
+}
+
+/// One frozen 10x10 legend table appended to many parents; nodes counts every appearance.
+Scenario    FrozenScenario(std::size_t copies)
+{
+    return {"frozen_shared", std::to_string(copies), 1 + copies * 111, [=]()
+    {
+        auto    legend = Get<Table>();
+
+        for (std::size_t r = 0; r < 10; ++r)
+        {
+            auto    row = legend->AppendChild(Get<TableRow>());
+
+            for (std::size_t c = 0; c < 10; ++c)
+            {
+                row->AppendChild(Get<TableElement>(std::to_string(r * 10 + c)));
+            }
+        }
+        legend->Freeze();
+
+        auto    root = Get<Div>();
+        for (std::size_t i = 0; i < copies; ++i)
+        {
+            root->AppendChild(legend);
+        }
+
+        return std::shared_ptr<NodeBase>(root);
+    }};
+}
+
+Scenario    DeepDivScenario(std::size_t depth)
+{
+    return {"deep_div", std::to_string(depth), depth, [=]()
+    {
+        auto    root = Get<Div>();
+        auto    node = std::shared_ptr<NodeBase>(root);
+
+        for (std::size_t i = 1; i < depth; ++i)
+        {
+            node = node->AppendChild(Get<Div>());
+        }
+
+        return std::shared_ptr<NodeBase>(root);
+    }};
+}
+
+Scenario    DeepSpanScenario(std::size_t depth)
+{
+    return {"deep_span", std::to_string(depth), depth, [=]()
+    {
+        auto    root = Get<Span>();
+        auto    node = std::shared_ptr<NodeBase>(root);
+
+        for (std::size_t i = 1; i < depth; ++i)
+        {
+            node = node->AppendChild(Get<Span>());
+        }
+
+        return std::shared_ptr<NodeBase>(root);
+    }};
+}
+
+Scenario    ParagraphScenario(std::size_t paragraphs, std::size_t inlines)
+{
+    return {"paragraphs", std::to_string(paragraphs) + "x" + std::to_string(inlines), 1 + paragraphs * (1 + inlines), [=]()
+    {
+        auto    root = Get<Div>();
+
+        for (std::size_t p = 0; p < paragraphs; ++p)
+        {
+            auto    paragraph = root->AppendChild(Get<Paragraph>("Lorem ipsum dolor sit amet, "));
+
+            for (std::size_t i = 0; i < inlines; ++i)
+            {
+                switch (i % 3)
+                {
+                case 0:     paragraph->AppendChild(Get<Text>("consectetur adipiscing elit, sed do eiusmod tempor "));   break;
+                case 1:     paragraph->AppendChild(Get<Link>("https://example.com/page/" + std::to_string(i), "link")); break;
+                default:    paragraph->AppendChild(Get<Break>());                                                       break;
+                }
+            }
+        }
+
+        return std::shared_ptr<NodeBase>(root);
+    }};
+}
+
+Scenario    ImageScenario(std::size_t images)
+{
+    return {"images", std::to_string(images), 1 + images, [=]()
+    {
+        auto    root = Get<Div>();
+
+        for (std::size_t i = 0; i < images; ++i)
+        {
+            root->AppendChild(Get<Image>("images/plot_" + std::to_string(i) + ".png", "Plot number " + std::to_string(i), 256, 128))
+                    ->AppendClass("thumbnail");
+        }
+
+        return std::shared_ptr<NodeBase>(root);
+    }};
+}
+
+//----------------------------------------------------------------------------
+/// A page with a large static skeleton and two slots, built from scratch per request.
+std::shared_ptr<Document>   BuildPage(bool slots, const std::string &user, const std::shared_ptr<NodeBase> &content)
+{
+    auto    doc = std::make_shared<Document>();
+    auto    head = doc->AppendChild(Get<Head>());
+
+    head->AppendChild(Get<Title>("Nightly report"));
+    for (int i = 0; i < 10; ++i)
+    {
+        head->AppendChild(Get<CSSResourceLink>("stylesheet", "https://example.com/style_" + std::to_string(i) + ".css"));
+    }
+
+    auto    body = doc->AppendChild(Get<Body>());
+    auto    navigation = body->AppendChild(Get<Div>());
+    for (int i = 0; i < 100; ++i)
+    {
+        navigation->AppendChild(Get<Link>("https://example.com/page/" + std::to_string(i), "Page " + std::to_string(i)));
+    }
+
+    auto    greeting = body->AppendChild(Get<Paragraph>("Logged in as "));
+    if (slots)
+    {
+        greeting->AppendChild(Get<Slot>("user", Sink::TextSlot));
+        body->AppendChild(Get<Slot>("content"));
+    }
+    else
+    {
+        greeting->AppendChild(Get<Text>(user));
+        body->AppendChild(content);
+    }
+
+    return doc;
+}
+
+void    RunTemplate()
+{
+    const int   repetitions = 10000;
+    auto        content = Get<Paragraph>("Everything is fine.");
+    std::size_t bytes = 0;
+
+    auto        start = Clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        bytes = BuildPage(false, "user", content)->Get().size();
+    }
+    double      rebuild_ns = Nanoseconds(start, Clock::now()) / repetitions;
+
+    const Template  page(*BuildPage(true, "", nullptr));
+
+    start = Clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        bytes = page.Render(TemplateValues().Set("user", "user").Set("content", std::shared_ptr<NodeBase>(content))).size();
+    }
+    double      template_ns = Nanoseconds(start, Clock::now()) / repetitions;
+
+    std::cout << "{\"scenario\":\"template\""
+              << ",\"output_bytes\":" << bytes
+              << ",\"rebuild_ns_per_page\":" << rebuild_ns
+              << ",\"template_ns_per_page\":" << template_ns
+              << "}" << std::endl;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    std::string filter = argc > 1 ? argv[1] : "";
+
+    std::vector<Scenario>   scenarios = {
+        TableScenario(100, 10),
+        TableScenario(1000, 10),
+        TableScenario(10000, 10),
+        TableScenario(100000, 10),
+        ColumnTableScenario(1000, 200),
+        ColumnTableScenario(100000, 10),
+        StatusTableScenario(100000, 10, false),
+        StatusTableScenario(100000, 10, true),
+        FrozenScenario(10000),
+        DeepDivScenario(1000),
+        DeepSpanScenario(100000),
+        ParagraphScenario(1000, 100),
+        ImageScenario(100000),
+    };
+
+    for (auto &s : scenarios)
+    {
+        if ((s.name + ":" + s.parameters).find(filter) != std::string::npos)
+        {
+            Run(s);
+        }
+    }
+
+    if (std::string("template").find(filter) != std::string::npos)
+    {
+        RunTemplate();
+    }
+
+    return 0;
+}
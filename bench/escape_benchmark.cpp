@@ -0,0 +1,100 @@
+//----------------------------------------------------------------------------
+// Compares simple_html::WriteEscaped() with a naive per-character escaper.
+//
+// Build:         cmake --build <dir> --target escape_benchmark
+// Output:        one JSON object per line and input density.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include <chrono>
+#include <random>
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+std::string NaiveEscape(const std::string &text, bool attribute)
+{
+    std::string result;
+
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '&':   result += "&amp;";  break;
+        case '<':   result += "&lt;";   break;
+        case '>':   result += "&gt;";   break;
+        case '"':   if (attribute) {result += "&quot;"; break;} result += c;   break;
+        case '\'':  if (attribute) {result += "&#39;"; break;}  result += c;   break;
+        default:    result += c;        break;
+        }
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------
+std::string MakeInput(std::size_t size, double density)
+{
+    const char      special[] = "&<>\"'";
+    std::mt19937    generator(42);
+    std::uniform_real_distribution<double>  uniform(0.0, 1.0);
+    std::string     result(size, ' ');
+
+    for (auto &c : result)
+    {
+        c = uniform(generator) < density ? special[generator() % 5] : char('a' + generator() % 26);
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------
+template<typename F>
+double  MegabytesPerSecond(std::size_t size, int repetitions, F function)
+{
+    auto    start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < repetitions; ++i)
+    {
+        function();
+    }
+
+    std::chrono::duration<double>   elapsed = std::chrono::steady_clock::now() - start;
+
+    return double(size) * repetitions / elapsed.count() / 1e6;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const std::size_t   size = 16 * 1024 * 1024;
+    const int           repetitions = 5;
+
+    for (double density : {0.0, 0.001, 0.01, 0.1})
+    {
+        std::string input = MakeInput(size, density);
+        std::size_t check = 0;
+
+        double  naive = MegabytesPerSecond(size, repetitions, [&]()
+        {
+            check += NaiveEscape(input, true).size();
+        });
+
+        double  vectorized = MegabytesPerSecond(size, repetitions, [&]()
+        {
+            std::string result;
+            StringSink  sink(result);
+
+            WriteEscaped<true>(sink, input);
+            sink.Flush();
+            check -= result.size();
+        });
+
+        std::cout << "{\"benchmark\":\"escape\",\"density\":" << density
+                  << ",\"naive_mb_per_s\":" << naive
+                  << ",\"vectorized_mb_per_s\":" << vectorized
+                  << ",\"sizes_match\":" << (check == 0 ? "true" : "false") << "}" << std::endl;
+    }
+
+    return 0;
+}
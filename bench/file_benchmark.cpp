@@ -0,0 +1,145 @@
+//----------------------------------------------------------------------------
+// Compares the ways of writing a large document to disk: `file << doc`,
+// Document::WriteToFile() buffered and mmap'ed, and a StreamWriter that never
+// holds more than one table row. With zlib, gzip output is compared between
+// rendering to a string first and compressing while rendering.
+//
+// Build:         cmake --build <dir> --target file_benchmark
+// Run:           file_benchmark [output file, default simple_html_benchmark.html]
+// Output:        one JSON object per line and method.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+const std::size_t   rows = 200000;
+const std::size_t   columns = 10;
+
+std::shared_ptr<TableRow>   MakeRow(std::size_t r)
+{
+    auto    row = Get<TableRow>();
+
+    for (std::size_t c = 0; c < columns; ++c)
+    {
+        row->AppendChild(Get<TableElement>(std::to_string(r * columns + c)));
+    }
+
+    return row;
+}
+
+void    Build(Document &doc)
+{
+    auto    table = doc.AppendChild(Get<Body>())->AppendChild(Get<Table>());
+
+    for (std::size_t r = 0; r < rows; ++r)
+    {
+        table->AppendChild(MakeRow(r));
+    }
+}
+
+/// Set by the compressing methods; reported next to the uncompressed size.
+std::size_t compressed_bytes = 0;
+
+//----------------------------------------------------------------------------
+void    Run(const std::string &method, const std::string &path, std::function<std::size_t()> write)
+{
+    auto        start = std::chrono::steady_clock::now();
+    std::size_t bytes = write();
+    std::chrono::duration<double>   elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "{\"benchmark\":\"file\",\"method\":\"" << method << "\""
+              << ",\"bytes\":" << bytes;
+    if (compressed_bytes > 0)
+    {
+        std::cout << ",\"compressed_bytes\":" << compressed_bytes;
+    }
+    std::cout << ",\"mb_per_s\":" << double(bytes) / elapsed.count() / 1e6 << "}" << std::endl;
+
+    compressed_bytes = 0;
+
+    std::remove(path.c_str());
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    std::string path = argc > 1 ? argv[1] : "simple_html_benchmark.html";
+    Document    doc;
+
+    Build(doc);
+
+    Run("ofstream", path, [&]()
+    {
+        std::ofstream   file(path);
+        file << doc;
+        return std::size_t(file.tellp());
+    });
+
+    Run("buffered", path, [&]()
+    {
+        return doc.WriteToFile(path);
+    });
+
+    Run("mapped", path, [&]()
+    {
+        FileOptions options;
+        options.method = FileOptions::Mapped;
+        return doc.WriteToFile(path, options);
+    });
+
+    Run("buffered_direct", path, [&]()
+    {
+        FileOptions options;
+        options.direct = true;
+        return doc.WriteToFile(path, options);
+    });
+
+    Run("streamed", path, [&]()
+    {
+        FileSink        sink(path);
+        StreamWriter    writer(sink);
+        {
+            auto    document = writer.Open(Get<Document>());
+            auto    body = writer.Open(Get<Body>());
+            auto    table = writer.Open(Get<Table>());
+
+            for (std::size_t r = 0; r < rows; ++r)
+            {
+                writer.Append(MakeRow(r));
+            }
+        }
+        return sink.Close();
+    });
+
+#ifdef SIMPLE_HTML_WITH_ZLIB
+    Run("gzip_two_pass", path, [&]()
+    {
+        std::string text = doc.Get();
+        FileSink    sink(path);
+        DeflateSink gzip(sink);
+
+        gzip.Write(text);
+        gzip.Finish();
+        compressed_bytes = sink.Close();
+        return gzip.UncompressedSize();
+    });
+
+    Run("gzip_streamed", path, [&]()
+    {
+        FileSink    sink(path);
+        DeflateSink gzip(sink);
+
+        doc.Write(gzip);
+        gzip.Finish();
+        compressed_bytes = sink.Close();
+        return gzip.UncompressedSize();
+    });
+#endif
+
+    return 0;
+}
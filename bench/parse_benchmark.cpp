@@ -0,0 +1,114 @@
+//----------------------------------------------------------------------------
+// Measures simple_html::HtmlParser and checks that parse -> Get() round-trips.
+//
+// Build:         cmake --build <dir> --target parse_benchmark
+// Output:        one JSON object per line and input; exits with 1 if the
+//                output of Get() does not parse back to the same output.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include <chrono>
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+std::shared_ptr<Document>   MakeDocument(int sections)
+{
+    auto    document = Get<Document>();
+    auto    head = document->AppendChild(GetHead());
+
+    head->AppendChild(GetTitle("Parse benchmark & round trip"));
+    head->AppendChild(Get<CSSResourceLink>("stylesheet", "style.css"));
+
+    auto    body = document->AppendChild(Get<Body>());
+
+    for (int s = 0; s < sections; ++s)
+    {
+        auto    div = body->AppendChild(Get<Div>());
+        div->AppendAttribute("class", "section");
+        div->AppendChild(GetHeading("Section " + std::to_string(s), 2));
+
+        auto    paragraph = div->AppendChild(GetParagraph("Measured values for run " + std::to_string(s) + " are < 5% off, see "));
+        paragraph->AppendChild(GetLink("https://example.com/runs?id=" + std::to_string(s) + "&view=full", "the full report"));
+        paragraph->AppendChild(GetText(" and the plot "));
+        paragraph->AppendChild(Get<Image>("plot" + std::to_string(s) + ".png", "Plot \"" + std::to_string(s) + "\"", 640, 480));
+
+        auto    table = div->AppendChild(Get<Table>("Results"));
+        auto    header = table->AppendChild(Get<TableRow>());
+        for (const char *name : {"x", "y", "error"})
+        {
+            header->AppendChild(Get<TableHeaderElement>(name));
+        }
+        for (int r = 0; r < 10; ++r)
+        {
+            auto    row = table->AppendChild(Get<TableRow>());
+            row->AppendAttribute("data-row", std::to_string(r));
+            row->AppendChild(Get<TableElement>(std::to_string(r)));
+            row->AppendChild(Get<TableElement>(std::to_string(r * s)));
+            row->AppendChild(Get<TableElement>(std::to_string(r * 0.25)))->AppendAttribute("class", "num");
+        }
+
+        auto    list = div->AppendChild(Get<UnorderedList>());
+        list->AppendChild(Get<ListItem>("first"));
+        list->AppendChild(Get<ListItem>("second"))->AppendChild(GetSuperScript("2"));
+    }
+
+    return document;
+}
+
+//----------------------------------------------------------------------------
+std::string Serialize(const std::vector<std::shared_ptr<NodeBase>> &nodes, const Layout &layout)
+{
+    std::string result;
+
+    for (auto &node : nodes)
+    {
+        result += node->Get(layout);
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------
+bool    Run(const std::string &name, Document &document, const Layout &layout, double build_seconds)
+{
+    std::string html = document.Get(layout);
+    int         repetitions = 10;
+    std::size_t nodes = 0;
+
+    auto    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        nodes += ParseHtml(html, layout).size();
+    }
+    std::chrono::duration<double>   elapsed = std::chrono::steady_clock::now() - start;
+
+    std::string once = Serialize(ParseHtml(html, layout), layout);
+    std::string twice = Serialize(ParseHtml(once, layout), layout);
+    bool        round_trip = once == html && twice == once;
+
+    std::cout << "{\"benchmark\":\"parse\",\"input\":\"" << name << "\",\"bytes\":" << html.size()
+              << ",\"mb_per_s\":" << double(html.size()) * repetitions / elapsed.count() / 1e6
+              << ",\"build_by_hand_mb_per_s\":" << double(html.size()) / build_seconds / 1e6
+              << ",\"roots\":" << nodes / repetitions
+              << ",\"round_trip\":" << (round_trip ? "true" : "false") << "}" << std::endl;
+
+    return round_trip;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // Building and freeing the same tree through the API bounds what parsing can reach.
+    auto    start = std::chrono::steady_clock::now();
+    MakeDocument(20000);
+    std::chrono::duration<double>   build = std::chrono::steady_clock::now() - start;
+
+    auto    document = MakeDocument(20000);
+    bool    ok = true;
+
+    ok = Run("document", *document, Layout(), build.count()) && ok;
+    ok = Run("document_minified", *document, Layout::Minified(), build.count()) && ok;
+
+    return ok ? 0 : 1;
+}
@@ -5,8 +5,53 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <stdexcept>
+#include <future>
+#include <thread>
+#include <system_error>
+#include <cstdlib>
+#include <cerrno>
+#include <charconv>
+#include <type_traits>
+#include <atomic>
+#include <typeinfo>
+
+#if __has_include(<unistd.h>) && __has_include(<sys/mman.h>)
+#define SIMPLE_HTML_HAS_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef SIMPLE_HTML_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef SIMPLE_HTML_PROFILE
+#include <chrono>
+#include <functional>
+#include <map>
+#include <typeindex>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 
 /**
@@ -87,11 +132,116 @@ void    Test(std::string output_filename)
 
 namespace simple_html
 {
+//----------------------------------------------------------------------------
+/**
+ * @brief The Arena class is a monotonic allocator handing out memory from a few large blocks.
+ *
+ * Memory is never returned to the arena piecemeal; all blocks are released at
+ * once when the arena is destroyed. An arena is not thread safe.
+ */
+class   Arena
+{
+    std::vector<std::unique_ptr<char[]>>    blocks;
+    char        *cursor{nullptr};
+    char        *limit{nullptr};
+    std::size_t block_size;
+    std::size_t allocated{0};
+
+public:
+    explicit Arena(std::size_t block_size = 64 * 1024)
+        : block_size(block_size)
+    {
+    }
+
+    Arena(const Arena &) = delete;
+    Arena&  operator=(const Arena &) = delete;
+
+    void*   Allocate(std::size_t size, std::size_t alignment)
+    {
+        std::size_t padding = (alignment - std::size_t(reinterpret_cast<std::uintptr_t>(cursor) % alignment)) % alignment;
+
+        if (cursor == nullptr || size + padding > std::size_t(limit - cursor))
+        {
+            std::size_t length = std::max(block_size, size + alignment);
+            blocks.emplace_back(new char[length]);
+
+            cursor = blocks.back().get();
+            limit = cursor + length;
+            padding = (alignment - std::size_t(reinterpret_cast<std::uintptr_t>(cursor) % alignment)) % alignment;
+        }
+
+        void    *result = cursor + padding;
+        cursor += padding + size;
+        allocated += size;
+
+        return result;
+    }
+
+    std::size_t BlockCount() const {return blocks.size();}
+    std::size_t BytesAllocated() const {return allocated;}
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The ArenaAllocator class is a standard allocator drawing from an Arena.
+ *
+ * Every allocation keeps the arena alive, so nodes may safely outlive the
+ * Document owning the arena.
+ */
+template<typename T>
+class   ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    std::shared_ptr<Arena>  arena;
+
+    ArenaAllocator(std::shared_ptr<Arena> arena)
+        : arena(std::move(arena))
+    {
+    }
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other)
+        : arena(other.arena)
+    {
+    }
+
+    T*      allocate(std::size_t n)
+    {
+        return static_cast<T*>(arena->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void    deallocate(T*, std::size_t)
+    {
+    }
+
+    template<typename U>
+    bool    operator==(const ArenaAllocator<U> &other) const {return arena == other.arena;}
+    template<typename U>
+    bool    operator!=(const ArenaAllocator<U> &other) const {return arena != other.arena;}
+};
+
+/**
+ * @brief CurrentArena returns the arena nodes are allocated from on this thread, or null.
+ */
+inline  std::shared_ptr<Arena>& CurrentArena()
+{
+    static thread_local std::shared_ptr<Arena>  current;
+    return current;
+}
+
 template<typename T, typename... Args>
 std::shared_ptr<T>  Get(Args&&... args)
 /// From: http://eli.thegreenplace.net/2014/variadic-templates-in-c/
 {
-//    return std::shared_ptr<T>(new T(std::forward<Args>(args)...));
+    auto    &arena = CurrentArena();
+
+    if (arena)
+    {
+        return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+    }
+
     return std::make_shared<T>(std::forward<Args>(args)...);
 }
 
@@ -120,6 +270,41 @@ public:
 #endif
     }
 };
+//----------------------------------------------------------------------------
+/**
+ * @brief The NumberFormat class selects how WriteNumber() formats floating point values.
+ */
+class   NumberFormat
+{
+public:
+    /// Digits after the decimal point (at most 100); negative gives the shortest text that reads back exactly.
+    int precision{-1};
+};
+
+/// Size of the buffer FormatNumber() needs for any value.
+inline  constexpr std::size_t   number_buffer_size{512};
+
+/**
+ * @brief FormatNumber writes value into buffer, independent of the locale, and returns the end.
+ *
+ * buffer must hold at least number_buffer_size characters.
+ */
+inline  char*   FormatNumber(char *buffer, double value, const NumberFormat &format = NumberFormat())
+{
+    if (format.precision < 0)
+    {
+        return std::to_chars(buffer, buffer + number_buffer_size, value).ptr;
+    }
+
+    return std::to_chars(buffer, buffer + number_buffer_size, value, std::chars_format::fixed, std::min(format.precision, 100)).ptr;
+}
+
+template<typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer>>>
+inline  char*   FormatNumber(char *buffer, Integer value)
+{
+    return std::to_chars(buffer, buffer + number_buffer_size, value).ptr;
+}
+
 //----------------------------------------------------------------------------
 /**
  * @brief The Attribute class handles a generic attribute like <..... attribute="value">.
@@ -129,25 +314,27 @@ class   Attribute : public AttributeBase
     std::string value{};
 public:
     Attribute(std::string name, std::string value)
-        : AttributeBase(name),
-          value(value)
+        : AttributeBase(std::move(name)),
+          value(std::move(value))
     {
 #ifdef __DEBUG
         std::cout << "Constructing Attribute" << std::endl;
 #endif
     }
     Attribute(std::string name, int value_int)
-        : AttributeBase(name),
-          value(std::to_string(value_int))
+        : AttributeBase(std::move(name))
     {
+        char    buffer[number_buffer_size];
+        value.assign(buffer, FormatNumber(buffer, value_int));
 #ifdef __DEBUG
         std::cout << "Constructing Attribute" << std::endl;
 #endif
     }
-    Attribute(std::string name, double value_double)
-        : AttributeBase(name),
-          value(std::to_string(value_double))
+    Attribute(std::string name, double value_double, NumberFormat format = NumberFormat())
+        : AttributeBase(std::move(name))
     {
+        char    buffer[number_buffer_size];
+        value.assign(buffer, FormatNumber(buffer, value_double, format));
 #ifdef __DEBUG
         std::cout << "Constructing Attribute" << std::endl;
 #endif
@@ -160,6 +347,8 @@ public:
     }
 
     virtual std::string Get() override {return name + "=" + "\"" + value + "\"";}
+
+    const std::string&  Value() const {return value;}
 };
 
 //----------------------------------------------------------------------------
@@ -171,7 +360,7 @@ class   IdAttribute : public Attribute
     std::string value{};
 public:
     IdAttribute(std::string identifier)
-        : Attribute("id", identifier)
+        : Attribute("id", std::move(identifier))
     {
 #ifdef __DEBUG
         std::cout << "Constructing IdAttribute" << std::endl;
@@ -194,7 +383,7 @@ class   ClassAttribute : public Attribute
     std::string value{};
 public:
     ClassAttribute(std::string identifier)
-        : Attribute("class", identifier)
+        : Attribute("class", std::move(identifier))
     {
 #ifdef __DEBUG
         std::cout << "Constructing ClassAttribute" << std::endl;
@@ -208,1036 +397,5769 @@ public:
     }
 };
 
-//----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 /**
- * @brief The NodeBase class is a base class for nodes.
+ * @brief The AttributeName class is an interned attribute name.
+ *
+ * Besides the name it holds the prefix ` name="` written in front of the value,
+ * so a start tag is emitted without building temporary strings.
  */
-class   NodeBase
+class   AttributeName
 {
-protected:
-    std::string name;
-    std::string value;
-    bool        _is_inline{false};
+public:
+    const std::string   name;
+    const std::string   prefix;
 
-    const char  indent_char{'\t'};
-    std::ostream&   StartTag(std::ostream &stream)
+    AttributeName(const std::string &name)
+        : name(name),
+          prefix(" " + name + "=\"")
     {
-        stream << "<" << name;
+    }
+};
+
+/**
+ * @brief CommonAttributeName returns the predefined AttributeName for name, or nullptr if there is none.
+ */
+inline  const AttributeName*    CommonAttributeName(std::string_view name)
+{
+    static const AttributeName  common[] = {
+        {"id"}, {"class"}, {"href"}, {"src"}, {"alt"}, {"style"}, {"rel"},
+        {"type"}, {"width"}, {"height"}, {"title"}, {"name"}, {"value"}
+    };
 
-        for (auto &a : attributes)
+    for (auto &c : common)
+    {
+        if (c.name == name)
         {
-            stream << " " << a->Get();
+            return &c;
         }
+    }
 
-        stream << ">";
+    return nullptr;
+}
 
-        return stream;
+/**
+ * @brief InternAttributeName returns the single AttributeName instance for name.
+ *
+ * The common names are looked up without locking; other names are added to a
+ * global pool on first use and live until the program ends.
+ */
+inline  const AttributeName&    InternAttributeName(const std::string &name)
+{
+    if (auto c = CommonAttributeName(name))
+    {
+        return *c;
     }
 
-    virtual std::ostream&   EndTag(std::ostream &stream)
-    {
-        stream << "</" << name << ">";
+    static std::mutex   mutex;
+    static std::unordered_map<std::string, std::unique_ptr<AttributeName>>  pool;
 
-        return stream;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto    &entry = pool[name];
+    if (!entry)
+    {
+        entry.reset(new AttributeName(name));
     }
 
-    std::ostream&   WriteIdentation(std::ostream &stream, int indentation)
+    return *entry;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The TagName class describes an element name together with its complete start and end tags.
+ *
+ * Serialization writes open and close with a single copy each, and nodes
+ * refer to a shared TagName instead of owning a name string.
+ */
+class   TagName
+{
+public:
+    std::string_view    name;
+    std::string_view    open;
+    std::string_view    close;
+};
+
+/**
+ * The tags used by the element classes below; Element<tags::xxx> builds further elements on them.
+ */
+namespace   tags
+{
+inline  constexpr TagName   text{"", "<>", "</>"};
+inline  constexpr TagName   html{"html", "<html>", "</html>"};
+inline  constexpr TagName   head{"head", "<head>", "</head>"};
+inline  constexpr TagName   body{"body", "<body>", "</body>"};
+inline  constexpr TagName   title{"title", "<title>", "</title>"};
+inline  constexpr TagName   link{"link", "<link>", "</link>"};
+inline  constexpr TagName   a{"a", "<a>", "</a>"};
+inline  constexpr TagName   img{"img", "<img>", "</img>"};
+inline  constexpr TagName   br{"br", "<br>", "</br>"};
+inline  constexpr TagName   h1{"h1", "<h1>", "</h1>"};
+inline  constexpr TagName   h2{"h2", "<h2>", "</h2>"};
+inline  constexpr TagName   h3{"h3", "<h3>", "</h3>"};
+inline  constexpr TagName   h4{"h4", "<h4>", "</h4>"};
+inline  constexpr TagName   h5{"h5", "<h5>", "</h5>"};
+inline  constexpr TagName   h6{"h6", "<h6>", "</h6>"};
+inline  constexpr TagName   span{"span", "<span>", "</span>"};
+inline  constexpr TagName   div{"div", "<div>", "</div>"};
+inline  constexpr TagName   sub{"sub", "<sub>", "</sub>"};
+inline  constexpr TagName   sup{"sup", "<sup>", "</sup>"};
+inline  constexpr TagName   p{"p", "<p>", "</p>"};
+inline  constexpr TagName   li{"li", "<li>", "</li>"};
+inline  constexpr TagName   ul{"ul", "<ul>", "</ul>"};
+inline  constexpr TagName   ol{"ol", "<ol>", "</ol>"};
+inline  constexpr TagName   table{"table", "<table>", "</table>"};
+inline  constexpr TagName   caption{"caption", "<caption>", "</caption>"};
+inline  constexpr TagName   tr{"tr", "<tr>", "</tr>"};
+inline  constexpr TagName   td{"td", "<td>", "</td>"};
+inline  constexpr TagName   th{"th", "<th>", "</th>"};
+
+inline  constexpr const TagName *all[] = {
+    &text, &html, &head, &body, &title, &link, &a, &img, &br,
+    &h1, &h2, &h3, &h4, &h5, &h6, &span, &div, &sub, &sup, &p,
+    &li, &ul, &ol, &table, &caption, &tr, &td, &th
+};
+} // namespace tags
+
+/**
+ * @brief StandardTagName returns the TagName from tags:: for name, or nullptr if there is none.
+ */
+inline  const TagName*  StandardTagName(std::string_view name)
+{
+    for (auto t : tags::all)
     {
-        if (!this->is_inline())
+        if (t->name == name)
         {
-            stream << std::string(indentation, indent_char);
+            return t;
         }
-
-        return stream;
     }
 
-    std::vector<std::shared_ptr<NodeBase>>  children;
-    std::vector<std::shared_ptr<AttributeBase>> attributes;
+    return nullptr;
+}
+
+/**
+ * @brief The OwnedTagName class is a TagName together with the text its views point into.
+ */
+class   OwnedTagName
+{
 public:
-    NodeBase(std::string name)
-        : name(name),
-          value("")
-    {
-#ifdef __DEBUG
-        std::cout << "Constructing NodeBase" << std::endl;
-#endif
-    }
-    NodeBase(std::string name, std::string value)
-        : name(name),
-          value(value)
+    const std::string   text;
+    TagName             tag;
+
+    /// Builds "<name></name>", with the three views pointing into it.
+    OwnedTagName(std::string_view name)
+        : text("<" + std::string(name) + "></" + std::string(name) + ">")
     {
-#ifdef __DEBUG
-        std::cout << "Constructing NodeBase" << std::endl;
-#endif
+        std::string_view    view = text;
+
+        tag.name = view.substr(1, name.size());
+        tag.open = view.substr(0, name.size() + 2);
+        tag.close = view.substr(name.size() + 2);
     }
 
-    virtual ~NodeBase()
+    OwnedTagName(const OwnedTagName&) = delete;
+    OwnedTagName&   operator=(const OwnedTagName&) = delete;
+};
+
+/**
+ * @brief InternTagName returns the TagName for a name only known at run time.
+ *
+ * Names from tags:: are returned directly; other names are added to a global
+ * pool on first use and live until the program ends.
+ */
+inline  const TagName&  InternTagName(std::string_view name)
+{
+    if (auto t = StandardTagName(name))
     {
-#ifdef __DEBUG
-        std::cout << "Destructing NodeBase" << std::endl;
-#endif
+        return *t;
     }
 
-    std::shared_ptr<Attribute>    AppendAttribute(const std::shared_ptr<Attribute> &a)
+    static std::mutex   mutex;
+    static std::unordered_map<std::string, std::unique_ptr<OwnedTagName>>   pool;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto    &entry = pool[std::string(name)];
+    if (!entry)
     {
-        attributes.push_back(a);
-        return a;
+        entry.reset(new OwnedTagName(name));
     }
 
-    std::shared_ptr<NodeBase>    AppendChild(const std::shared_ptr<NodeBase> &a)
+    return entry->tag;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The AttributeEntry class is a name/value pair stored inline in a node.
+ */
+class   AttributeEntry
+{
+public:
+    enum    Kind : std::uint8_t
     {
-        children.push_back(a);
-        return a;
-    }
+        Text,       ///< value holds the text.
+        Integer,    ///< integer is formatted when the tag is written.
+        Number,     ///< number is formatted with format when the tag is written.
+        TemplateSlot    ///< value names a Template slot.
+    };
+
+    const AttributeName *name{nullptr};
+    std::string         value;
+    Kind                kind{Text};
+    NumberFormat        format;
+    union
+    {
+        std::int64_t    integer{0};
+        double          number;
+    };
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The AttributeList class is a small vector of attributes.
+ *
+ * The first few attributes are stored inside the node itself; only nodes with
+ * more attributes than that allocate.
+ */
+class   AttributeList
+{
+    static const std::size_t    inline_capacity = 2;
+
+    AttributeEntry              inline_entries[inline_capacity];
+    std::vector<AttributeEntry> overflow;
+    std::size_t                 count{0};
+
+public:
+    std::size_t size() const {return count;}
+    bool        empty() const {return count == 0;}
 
-    std::shared_ptr<Attribute>    AppendId(std::string id)
+    AttributeEntry&         operator[](std::size_t i)
     {
-        return AppendAttribute(std::make_shared<IdAttribute>(id));
+        return i < inline_capacity ? inline_entries[i] : overflow[i - inline_capacity];
     }
 
-    std::shared_ptr<Attribute>  AppendClass(std::string name)
+    const AttributeEntry&   operator[](std::size_t i) const
     {
-        return AppendAttribute(std::make_shared<ClassAttribute>(name));
+        return i < inline_capacity ? inline_entries[i] : overflow[i - inline_capacity];
     }
 
-    virtual std::string Get(int indentation = 0)
+    AttributeEntry&         Append(const AttributeName &name, std::string value)
     {
-        std::stringstream   stream;
+        AttributeEntry  *entry;
 
-        WriteIdentation(stream, indentation);
-        StartTag(stream);
-
-        if (value.length() > 0)
+        if (count < inline_capacity)
         {
-            stream << std::endl << std::string(indentation + 1, indent_char);
-            stream << value;
+            entry = &inline_entries[count];
         }
-
-        for (auto &c : children)
+        else
         {
-            if (!c->is_inline())
-            {
-                stream << std::endl;
-            }
-            stream << c->Get(indentation + 1);
-//            stream << std::string(indentation, indent_char) << c->Get(indentation + 1);
+            overflow.emplace_back();
+            entry = &overflow.back();
         }
 
-        stream << std::endl << std::string(indentation, indent_char);
-        EndTag(stream);
-//        stream << std::endl;
+        ++count;
+        entry->name = &name;
+        entry->value = std::move(value);
 
-        return stream.str();
+        return *entry;
     }
-
-    bool    is_inline() {return _is_inline;}
-
-    friend  std::ostream& operator<<(std::ostream &stream, NodeBase &node);
 };
 
-inline  std::ostream& operator<<(std::ostream &stream, NodeBase &node)
+#ifdef SIMPLE_HTML_PROFILE
+//----------------------------------------------------------------------------
+/**
+ * @brief The ProfileStats class holds what a Profiler measured.
+ */
+class   ProfileStats
 {
-    return stream << node.Get();
-}
+public:
+    class   TypeStats
+    {
+    public:
+        std::size_t nodes{0};
+        /// Bytes written by the nodes themselves, excluding their children.
+        std::size_t bytes{0};
+    };
 
-inline  std::shared_ptr<NodeBase>   GetNodeBase(std::string name)
-{
-    return std::make_shared<NodeBase>(name);
-}
+    class   SlowSubtree
+    {
+    public:
+        std::string                 type;
+        std::size_t                 depth;
+        std::size_t                 bytes;
+        std::chrono::nanoseconds    time;
+    };
+
+    /// Per node type, e.g. "TableElement", "Text" or "Image".
+    std::map<std::string, TypeStats>    types;
+    /// Subtrees that took at least ProfileOptions::slow_threshold, innermost first.
+    std::vector<SlowSubtree>            slow_subtrees;
+    std::size_t nodes{0};
+    std::size_t bytes{0};
+    /// Heap allocations made by the serializer: output buffer growth and cache fills.
+    std::size_t allocations{0};
+    /// Deepest nesting level written; the node serialized is at level 1.
+    std::size_t max_depth{0};
+};
 
-inline  std::shared_ptr<NodeBase>   GetNodeBase(std::string name, std::string value)
+/**
+ * @brief The TraceEvent class describes one written node, see ProfileOptions::trace.
+ */
+class   TraceEvent
 {
-    return std::make_shared<NodeBase>(name, value);
-}
+public:
+    const std::string           &type;
+    std::size_t                 depth;
+    /// Bytes of the whole subtree.
+    std::size_t                 bytes;
+    std::chrono::nanoseconds    time;
+};
 
+/**
+ * @brief The ProfileOptions class controls a Profiler.
+ */
+class   ProfileOptions
+{
+public:
+    std::chrono::nanoseconds    slow_threshold{std::chrono::milliseconds(1)};
+    /// Called after every node is written, if set.
+    std::function<void(const TraceEvent&)>  trace;
+};
 
 //----------------------------------------------------------------------------
 /**
- * @brief The Void class handles a void node (node without end tag) like <br> or <img>.
+ * @brief The Profiler class collects serialization statistics while a ProfileScope is active.
+ *
+ * Only compiled with SIMPLE_HTML_PROFILE defined; without it none of the
+ * hooks exist. Write(), Get() and the functions built on them report to the
+ * profiler of the calling thread:
+ *
+ *      Profiler    profiler;
+ *      {
+ *          ProfileScope    scope(profiler);
+ *          doc.Get();
+ *      }
+ *      profiler.Stats().types["TableElement"].bytes;
  */
-class   Void : public NodeBase
+class   Profiler
 {
-    std::ostream&   EndTag(std::ostream &stream) override
+    using   Clock = std::chrono::steady_clock;
+
+    class   Type
+    {
+    public:
+        const std::string       *name;
+        ProfileStats::TypeStats *stats;
+    };
+
+    class   Frame
+    {
+    public:
+        Type                type;
+        std::size_t         start;
+        std::size_t         children;
+        Clock::time_point   time;
+    };
+
+    ProfileOptions  options;
+    ProfileStats    stats;
+    std::vector<Frame>  stack;
+    std::unordered_map<std::type_index, Type>   types;
+
+    static std::string  TypeName(const std::type_info &type)
+    {
+        std::string name = type.name();
+#if defined(__GNUG__)
+        int     status = 0;
+        char    *demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+        if (status == 0 && demangled != nullptr)
+        {
+            name = demangled;
+        }
+        std::free(demangled);
+#endif
+        if (name.compare(0, 13, "simple_html::") == 0)
+        {
+            name.erase(0, 13);
+        }
+
+        return name;
+    }
+
+    Type    Lookup(const std::type_info &type)
     {
-        return stream;
+        auto    found = types.find(type);
+        if (found != types.end())
+        {
+            return found->second;
+        }
+
+        auto    entry = stats.types.emplace(TypeName(type), ProfileStats::TypeStats()).first;
+        Type    result{&entry->first, &entry->second};
+        types.emplace(type, result);
+
+        return result;
     }
+
 public:
-    Void(std::string name)
-        : NodeBase(name)
+    Profiler(ProfileOptions options = ProfileOptions())
+        : options(std::move(options))
     {
-#ifdef __DEBUG
-        std::cout << "Constructing Void" << std::endl;
-#endif
     }
-    virtual ~Void()
+
+    const ProfileStats& Stats() const {return stats;}
+
+    void    Reset()
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Void" << std::endl;
-#endif
+        stats = ProfileStats();
+        stack.clear();
+        types.clear();
     }
 
-    virtual std::string Get(int indentation = 0) override
+    /// A node of type starts at output position.
+    void    Enter(const std::type_info &type, std::size_t position)
     {
-        std::stringstream   stream;
+        stack.push_back({Lookup(type), position, 0, Clock::now()});
+        ++stack.back().type.stats->nodes;
+        ++stats.nodes;
+        stats.max_depth = std::max(stats.max_depth, stack.size());
+    }
+
+    /// The node entered last ends at output position.
+    void    Leave(std::size_t position)
+    {
+        Frame   frame = stack.back();
+        stack.pop_back();
+
+        std::size_t                 bytes = position - frame.start;
+        std::chrono::nanoseconds    time = Clock::now() - frame.time;
 
-        WriteIdentation(stream, indentation);
-        StartTag(stream);
+        frame.type.stats->bytes += bytes - frame.children;
+        stats.bytes += bytes - frame.children;
+        if (!stack.empty())
+        {
+            stack.back().children += bytes;
+        }
+
+        if (time >= options.slow_threshold)
+        {
+            stats.slow_subtrees.push_back({*frame.type.name, stack.size() + 1, bytes, time});
+        }
+        if (options.trace)
+        {
+            options.trace(TraceEvent{*frame.type.name, stack.size() + 1, bytes, time});
+        }
+    }
 
-        return stream.str();
+    /// A subtree of type written from a cache in one piece.
+    void    Cached(const std::type_info &type, std::size_t position, std::size_t bytes)
+    {
+        Enter(type, position);
+        Leave(position + bytes);
     }
+
+    void    Allocation() {++stats.allocations;}
 };
 
-inline  std::shared_ptr<Void>   GetVoid(std::string name)
+inline  Profiler*&  CurrentProfiler()
 {
-    return std::make_shared<Void>(name);
+    static thread_local Profiler    *profiler{nullptr};
+    return profiler;
 }
 
-//----------------------------------------------------------------------------
 /**
- * @brief The NodeLine class handles a one-line node.
+ * @brief The ProfileScope class makes profiler the profiler of this thread while in scope.
  */
-class   NodeLine : public NodeBase
+class   ProfileScope
 {
+    Profiler    *previous;
 public:
-    NodeLine(std::string name)
-        : NodeBase(name)
+    ProfileScope(Profiler &profiler)
+        : previous(CurrentProfiler())
     {
-#ifdef __DEBUG
-        std::cout << "Constructing NodeLine" << std::endl;
-#endif
+        CurrentProfiler() = &profiler;
     }
-    NodeLine(std::string name, std::string value)
-        : NodeBase(name, value)
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope& operator=(const ProfileScope &) = delete;
+
+    ~ProfileScope()
     {
-#ifdef __DEBUG
-        std::cout << "Constructing NodeLine" << std::endl;
-#endif
+        CurrentProfiler() = previous;
     }
-    virtual ~NodeLine()
-    {
-#ifdef __DEBUG
-        std::cout << "Destructing NodeLine" << std::endl;
+};
 #endif
-    }
-
-    virtual std::string Get(int indentation = 0) override
-    {
-        std::stringstream   stream;
 
-        WriteIdentation(stream, indentation);
-        StartTag(stream);
-
-        if (value.length() > 0)
-        {
-            stream << value;
-        }
+//----------------------------------------------------------------------------
+/**
+ * @brief The Layout class controls the whitespace between elements.
+ *
+ * The default is one tab per level and a newline in front of every block
+ * element, as the library has always written.
+ */
+class   Layout
+{
+public:
+    /// Newlines in front of block elements and their end tags.
+    bool    newlines{true};
+    /// Character repeated indent_width times per indentation level.
+    char    indent_char{'\t'};
+    int     indent_width{1};
 
-        for (auto &c : children)
-        {
-            if (!c->is_inline())
-            {
-                stream << std::endl;
-            }
-            stream << c->Get(indentation + 1);
-        }
+    /// No newlines and no indentation.
+    static Layout   Minified() {return Layout{false, ' ', 0};}
+    /// Indents by width spaces per level.
+    static Layout   Spaces(int width) {return Layout{true, ' ', width};}
 
-        EndTag(stream);
+    std::size_t NewlineSize() const {return newlines ? 1 : 0;}
+    std::size_t IndentSize(int indentation) const {return std::size_t(indentation) * std::size_t(indent_width);}
 
-        return stream.str();
+    bool    operator==(const Layout &other) const
+    {
+        return newlines == other.newlines && indent_char == other.indent_char && indent_width == other.indent_width;
     }
-};
-
-inline  std::shared_ptr<NodeLine>   GetNodeLine(std::string name)
-{
-    return std::make_shared<NodeLine>(name);
-}
 
-inline  std::shared_ptr<NodeLine>   GetNodeLine(std::string name, std::string value)
-{
-    return std::make_shared<NodeLine>(name, value);
-}
+    bool    operator!=(const Layout &other) const {return !(*this == other);}
+};
 
+//----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 /**
- * @brief The NodeInline class handles a one-line node inserted inline.
+ * @brief The Sink class is a base class for serialization targets.
+ *
+ * Nodes write their output through a Sink in one pass. Bytes are copied into
+ * the window [cursor, limit) supplied by the derived class, and Overflow() is
+ * only called when a write does not fit.
  */
-class   NodeInline : public NodeLine
+class   Sink
 {
+protected:
+    char        *base{nullptr};
+    char        *cursor{nullptr};
+    char        *limit{nullptr};
+    std::size_t flushed{0};
+    Layout      layout;
+    std::size_t separator{0};   // see EndSeparator()
+
+    virtual void    Overflow(const char *data, std::size_t size) = 0;
+
 public:
-    NodeInline(std::string name)
-        : NodeLine(name)
+    virtual ~Sink() {}
+
+    void    Write(const char *data, std::size_t size)
     {
-        _is_inline = true;
-#ifdef __DEBUG
-        std::cout << "Constructing NodeInline" << std::endl;
-#endif
+        if (size <= std::size_t(limit - cursor))
+        {
+            std::memcpy(cursor, data, size);
+            cursor += size;
+        }
+        else
+        {
+            Overflow(data, size);
+        }
     }
-    NodeInline(std::string name, std::string value)
-        : NodeLine(name, value)
+
+    void    Write(const std::string &text)
     {
-        _is_inline = true;
-#ifdef __DEBUG
-        std::cout << "Constructing NodeInline" << std::endl;
-#endif
+        Write(text.data(), text.size());
     }
-    virtual ~NodeInline()
+
+    void    Put(char c)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing NodeInline" << std::endl;
-#endif
+        if (cursor != limit)
+        {
+            *cursor++ = c;
+        }
+        else
+        {
+            Overflow(&c, 1);
+        }
     }
 
-    virtual std::string Get(int indentation = 0) override
+    void    Fill(char c, std::size_t count)
     {
-        std::stringstream   stream;
-
-        WriteIdentation(stream, indentation);
-        StartTag(stream);
-
-        if (value.length() > 0)
+        if (count <= std::size_t(limit - cursor))
         {
-            stream << value;
+            std::memset(cursor, c, count);
+            cursor += count;
         }
-
-        for (auto &c : children)
+        else
         {
-            stream << c->Get(indentation + 1);
+            while (count-- > 0)
+            {
+                Put(c);
+            }
         }
-
-        EndTag(stream);
-
-        return stream.str();
     }
-};
 
-inline  std::shared_ptr<NodeInline>   GetNodeInline(std::string name)
-{
-    return std::make_shared<NodeInline>(name);
-}
+    /// Total number of bytes written through the sink.
+    std::size_t Size() const {return flushed + std::size_t(cursor - base);}
 
-inline  std::shared_ptr<NodeInline>   GetNodeInline(std::string name, std::string value)
-{
-    return std::make_shared<NodeInline>(name, value);
-}
+    /// Records that the bytes written since start separate the next child from what its parent wrote before it.
+    void        EndSeparator(std::size_t start) {separator = Size() - start;}
+    /// The size of the separator recorded last, which a Slot passes on to WriteSlot().
+    std::size_t LastSeparator() const {return separator;}
 
-//----------------------------------------------------------------------------
-//----------------------------------------------------------------------------
-/**
- * @brief The Document class handles a document node, <html></html>.
- */
-class   Document : public NodeBase
-{
-public:
-    Document()
-        : NodeBase("html")
-    {
-#ifdef __DEBUG
-        std::cout << "Constructing Document" << std::endl;
-#endif
-    }
+    /// The whitespace nodes write through Newline() and Indent().
+    const Layout&   GetLayout() const {return layout;}
+    void            SetLayout(const Layout &layout) {this->layout = layout;}
 
-    virtual ~Document()
+    void    Newline()
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Document" << std::endl;
-#endif
+        if (layout.newlines)
+        {
+            Put('\n');
+        }
     }
 
-    virtual std::string Get(int indentation = 0) override
+    void    Indent(int indentation)
     {
-        std::stringstream   stream;
-        stream << "<!DOCTYPE html>" << std::endl;
-        stream << NodeBase::Get(indentation);
-
-        return stream.str();
+        Fill(layout.indent_char, layout.IndentSize(indentation));
     }
-};
 
-inline  std::ostream& operator<<(std::ostream &stream, Document &node)
-{
-    return stream << node.Get();
-}
+    virtual void    Flush() {}
 
+    enum    SlotKind
+    {
+        NodeSlot,       ///< A child node, see Slot.
+        TextSlot,       ///< Inline text, see Slot.
+        AttributeSlot   ///< An attribute value, see NodeBase::AppendAttributeSlot().
+    };
+
+    /**
+     * Called where a template slot is; only the sink compiling a Template records it.
+     *
+     * separator is the number of bytes just written in front of the slot that
+     * only belong in the output if the slot is filled with a block node.
+     */
+    virtual void    WriteSlot(SlotKind /*kind*/, const std::string &/*name*/, int /*indentation*/, std::size_t /*separator*/) {}
+};
 
 //----------------------------------------------------------------------------
 /**
- * @brief The Head class handles a head node, <head></head>.
+ * @brief The StringSink class appends serialized output to a std::string.
+ *
+ * The string is used directly as the write buffer, so the target holds spare
+ * bytes until Flush() (or the destructor) trims it to the written size.
  */
-class   Head : public NodeBase
+class   StringSink : public Sink
 {
-public:
-    Head()
-        : NodeBase("head")
+    std::string &target;
+    std::size_t offset;
+
+    void    Overflow(const char *data, std::size_t size) override
     {
-#ifdef __DEBUG
-        std::cout << "Constructing Head" << std::endl;
+        std::size_t used = offset + Size();
+        target.resize(std::max(std::max(used + size, 2 * target.size()), std::size_t(256)));
+#ifdef SIMPLE_HTML_PROFILE
+        if (Profiler *profiler = CurrentProfiler())
+        {
+            profiler->Allocation();
+        }
 #endif
+
+        base = &target[0] + offset;
+        cursor = &target[0] + used;
+        limit = &target[0] + target.size();
+
+        std::memcpy(cursor, data, size);
+        cursor += size;
     }
 
-    virtual ~Head()
+public:
+    StringSink(std::string &target)
+        : target(target),
+          offset(target.size())
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Head" << std::endl;
-#endif
+        base = cursor = limit = &target[0] + offset;
     }
-};
-
-inline  std::shared_ptr<Head>   GetHead()
-{
-    return std::make_shared<Head>();
-}
 
-//----------------------------------------------------------------------------
-/**
- * @brief The Body class handles a body node, <body></body>.
- */
-class   Body : public NodeBase
-{
-public:
-    Body()
-        : NodeBase("body")
+    virtual ~StringSink()
     {
-#ifdef __DEBUG
-        std::cout << "Constructing Body" << std::endl;
-#endif
+        Flush();
     }
 
-    virtual ~Body()
+    /// The bytes written so far; valid until the next write.
+    const char* Data() const {return base;}
+
+    void    Flush() override
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Body" << std::endl;
-#endif
+        std::size_t used = Size();
+        target.resize(offset + used);
+
+        base = &target[0] + offset;
+        cursor = limit = base + used;
     }
 };
 
-inline  std::shared_ptr<Body>   GetNodeInline()
-{
-    return std::make_shared<Body>();
-}
-
-//----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 /**
- * @brief The ResourceLink class handles a resource link, <link rel="relation">.
+ * @brief The StreamSink class writes serialized output to a std::ostream through a small buffer.
  */
-class   ResourceLink : public Void
+class   StreamSink : public Sink
 {
+    std::ostream    &stream;
+    char            buffer[4096];
+
+    void    Overflow(const char *data, std::size_t size) override
+    {
+        Flush();
+
+        if (size < sizeof(buffer))
+        {
+            std::memcpy(cursor, data, size);
+            cursor += size;
+        }
+        else
+        {
+            stream.write(data, std::streamsize(size));
+            flushed += size;
+        }
+    }
+
 public:
-    ResourceLink(std::string relation)
-        : Void("link")
+    StreamSink(std::ostream &stream)
+        : stream(stream)
     {
-        this->AppendAttribute(std::shared_ptr<Attribute>(new Attribute("rel", relation)));
-#ifdef __DEBUG
-        std::cout << "Constructing ResourceLink" << std::endl;
-#endif
+        base = cursor = buffer;
+        limit = buffer + sizeof(buffer);
     }
 
-    virtual ~ResourceLink()
+    virtual ~StreamSink()
     {
-#ifdef __DEBUG
-        std::cout << "Destructing ResourceLink" << std::endl;
-#endif
+        Flush();
     }
-};
 
-inline  std::shared_ptr<ResourceLink>   GetResourceLink(std::string relation)
-{
-    return std::make_shared<ResourceLink>(relation);
-}
+    void    Flush() override
+    {
+        stream.write(base, std::streamsize(cursor - base));
+        flushed += std::size_t(cursor - base);
+        cursor = base;
+    }
+};
 
 //----------------------------------------------------------------------------
 /**
- * @brief The CSSResourceLink class handles a css resource link, <link rel="relation", href="url", type="text/css">.
+ * @brief The BufferSink class writes serialized output into a fixed, caller supplied buffer.
+ *
+ * Writing past the end of the buffer throws std::length_error.
  */
-class   CSSResourceLink : public ResourceLink
+class   BufferSink : public Sink
 {
-public:
-    CSSResourceLink(std::string relation, std::string url)
-        : ResourceLink(relation)
+    void    Overflow(const char * /*data*/, std::size_t /*size*/) override
     {
-        this->AppendAttribute(std::shared_ptr<Attribute>(new Attribute("href", url)));
-        this->AppendAttribute(std::shared_ptr<Attribute>(new Attribute("type", "text/css")));
-#ifdef __DEBUG
-        std::cout << "Constructing ResourceLink" << std::endl;
-#endif
+        throw std::length_error("simple_html::BufferSink: buffer too small");
     }
 
-    virtual ~CSSResourceLink()
+public:
+    BufferSink(char *buffer, std::size_t capacity)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing ResourceLink" << std::endl;
-#endif
+        base = cursor = buffer;
+        limit = buffer + capacity;
     }
 };
 
+#ifdef SIMPLE_HTML_HAS_POSIX
 //----------------------------------------------------------------------------
 /**
- * @brief The Link class handles a one-line link tag <a href="url">text</a>.
+ * @brief The FileOptions class controls Document::WriteToFile().
  */
-class   Link : public NodeInline
+class   FileOptions
 {
 public:
-    Link(std::string url, std::string text)
-        : NodeInline("a", text)
+    enum    Method
     {
-        this->AppendAttribute(std::shared_ptr<Attribute>(new Attribute("href", url)));
-#ifdef __DEBUG
-        std::cout << "Constructing Link" << std::endl;
-#endif
-    }
+        Buffered,   ///< Serialize into a buffer and write(2) it whenever it is full.
+        Mapped      ///< Size the file with SerializedSize() and serialize into an mmap'ed view.
+    };
 
-    virtual ~Link()
+    enum    Sync
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Link" << std::endl;
-#endif
-    }
+        NoSync,     ///< Leave it to the operating system.
+        DataSync,   ///< fdatasync() before closing.
+        FullSync    ///< fsync() before closing.
+    };
+
+    Method      method{Buffered};
+    Sync        sync{NoSync};
+    /// Size of the write buffer, rounded up to a multiple of 4096 bytes.
+    std::size_t buffer_size{1 << 20};
+    /// Open the file with O_DIRECT, bypassing the page cache (Buffered only).
+    bool        direct{false};
+    /// Whitespace of the output, e.g. Layout::Minified().
+    Layout      layout;
 };
 
-inline  std::shared_ptr<Link>   GetLink(std::string url, std::string text)
-{
-    return std::make_shared<Link>(url, text);
-}
-
 //----------------------------------------------------------------------------
 /**
- * @brief The Image class handles an image tag, <img ...>.
+ * @brief The FileSink class writes serialized output to a file through a large aligned buffer.
+ *
+ * Memory use is bounded by the buffer size, whatever the size of the output.
+ * Close() writes the tail, applies the sync policy and reports failures as
+ * std::system_error; the destructor only closes the file.
  */
-class   Image : public Void
+class   FileSink : public Sink
 {
-public:
-    //<img src="pic_mountain.jpg" alt="Mountain View" style="width:304px;height:228px;">
-    Image(std::string url, std::string alt_text, int width, int height, bool old_style = false)
-        : Void("img")
+    static constexpr std::size_t    alignment{4096};
+
+    int         fd{-1};
+    bool        direct{false};
+    FileOptions::Sync   sync;
+    std::unique_ptr<char, decltype(&std::free)> buffer{nullptr, &std::free};
+
+    static void Fail(const char *operation)
     {
-        _is_inline = true;
-#ifdef __DEBUG
-        std::cout << "Constructing Image" << std::endl;
-#endif
+        throw std::system_error(errno, std::generic_category(), std::string("simple_html::FileSink: ") + operation);
+    }
 
-        this->AppendAttribute(std::shared_ptr<Attribute>(new Attribute("src", url)));
-        this->AppendAttribute(std::shared_ptr<Attribute>(new Attribute("alt", alt_text)));
+    void    WriteBuffer()
+    {
+        const char  *data = base;
+        std::size_t size = std::size_t(cursor - base);
 
-        if (!old_style)
+        if (direct && size % alignment != 0)
         {
-        std::stringstream style;
-        style << "width:" << width << "px;";
-        style << "height:" << height << "px";
-        this->AppendAttribute(std::shared_ptr<Attribute>(new Attribute("style", style.str())));
+            // O_DIRECT needs whole blocks, so the tail goes through the page cache.
+            if (::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_DIRECT) == -1)
+            {
+                Fail("fcntl");
+            }
+            direct = false;
         }
-        else
+
+        while (size > 0)
         {
-            this->AppendAttribute(std::shared_ptr<Attribute>(new Attribute("width", width)));
-            this->AppendAttribute(std::shared_ptr<Attribute>(new Attribute("height", height)));
+            ssize_t written = ::write(fd, data, size);
+
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                Fail("write");
+            }
+
+            data += written;
+            size -= std::size_t(written);
         }
+
+        flushed += std::size_t(cursor - base);
+        cursor = base;
     }
 
-    virtual ~Image()
+    void    Overflow(const char *data, std::size_t size) override
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Image" << std::endl;
-#endif
+        while (size > 0)
+        {
+            std::size_t part = std::min(size, std::size_t(limit - cursor));
+
+            std::memcpy(cursor, data, part);
+            cursor += part;
+            data += part;
+            size -= part;
+
+            if (cursor == limit)
+            {
+                WriteBuffer();
+            }
+        }
     }
-};
 
-//----------------------------------------------------------------------------
-/**
- * @brief The Break class handles a break tag, <br>.
- */
-class   Break : public Void
-{
 public:
-    Break()
-        : Void("br")
+    FileSink(const std::string &path, const FileOptions &options = FileOptions())
+        : sync(options.sync)
     {
-#ifdef __DEBUG
-        std::cout << "Constructing Break" << std::endl;
+        std::size_t capacity = std::max(alignment, (options.buffer_size + alignment - 1) / alignment * alignment);
+        int         flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+
+#ifdef O_DIRECT
+        if (options.direct)
+        {
+            fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+            // Not every file system supports O_DIRECT; fall back to the page cache there.
+            direct = fd != -1;
+        }
 #endif
+        if (fd == -1)
+        {
+            fd = ::open(path.c_str(), flags, 0644);
+        }
+        if (fd == -1)
+        {
+            Fail("open");
+        }
+
+        buffer.reset(static_cast<char*>(std::aligned_alloc(alignment, capacity)));
+        if (!buffer)
+        {
+            ::close(fd);
+            throw std::bad_alloc();
+        }
+
+        base = cursor = buffer.get();
+        limit = base + capacity;
+        layout = options.layout;
     }
-    virtual ~Break()
+
+    virtual ~FileSink()
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Break" << std::endl;
-#endif
+        if (fd != -1)
+        {
+            ::close(fd);
+        }
     }
-};
-
-inline  std::shared_ptr<Break>   GetBreak()
-{
-    return std::make_shared<Break>();
-}
 
-//----------------------------------------------------------------------------
-/**
- * @brief The Title class handles a one-line title node, <title></title>.
- */
-class   Title : public NodeLine
-{
-public:
-    Title(std::string text)
-        : NodeLine("title", text)
+    void    Flush() override
     {
-#ifdef __DEBUG
-       std:: cout << "Constructing Title" << std::endl;
-#endif
+        WriteBuffer();
     }
 
-    virtual ~Title()
+    /// Writes the remaining output, syncs according to the options and closes the file.
+    std::size_t Close()
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Title" << std::endl;
-#endif
+        WriteBuffer();
+
+        if ((sync == FileOptions::DataSync && ::fdatasync(fd) == -1) ||
+            (sync == FileOptions::FullSync && ::fsync(fd) == -1))
+        {
+            Fail("sync");
+        }
+
+        int result = ::close(fd);
+        fd = -1;
+        if (result == -1)
+        {
+            Fail("close");
+        }
+
+        return Size();
     }
 };
+#endif
 
-inline  std::shared_ptr<Title>   GetTitle(std::string text)
-{
-    return std::make_shared<Title>(text);
-}
-
+#ifdef SIMPLE_HTML_WITH_ZLIB
 //----------------------------------------------------------------------------
 /**
- * @brief The Heading class handles a one-line heading node, <h[level]></h[level]>.
+ * @brief The DeflateOptions class controls DeflateSink.
  */
-class   Heading : public NodeLine
+class   DeflateOptions
 {
 public:
-    Heading(std::string text, int level)
-        : NodeLine("", text)
-    {
-        name = std::string("h") + std::to_string(level);
-
-#ifdef __DEBUG
-       std:: cout << "Constructing Heading" << std::endl;
-#endif
-    }
-
-    virtual ~Heading()
+    enum    Format
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Heading" << std::endl;
-#endif
-    }
+        Gzip,   ///< gzip header and trailer, for Content-Encoding: gzip and .gz files.
+        Zlib,   ///< zlib header and trailer, for Content-Encoding: deflate.
+        Raw     ///< Bare deflate stream.
+    };
+
+    Format      format{Gzip};
+    /// 0 (store) to 9 (smallest); Z_DEFAULT_COMPRESSION picks zlib's default, 6.
+    int         level{Z_DEFAULT_COMPRESSION};
+    /// Bytes of serialized output collected before each deflate() call.
+    std::size_t buffer_size{64 * 1024};
 };
 
-inline  std::shared_ptr<Heading>   GetHeading(std::string text, int level)
-{
-    return std::make_shared<Heading>(text, level);
-}
-
 //----------------------------------------------------------------------------
 /**
- * @brief The Text class handles a one-line node without tags representing text.
+ * @brief The DeflateSink class compresses serialized output with zlib on its way to another sink.
+ *
+ * Compression runs on each buffer as the tree is written, so the uncompressed
+ * document never exists in full:
+ *
+ *      std::string     body;
+ *      StringSink      target(body);
+ *      DeflateSink     gzip(target);
+ *
+ *      doc.Write(gzip);
+ *      gzip.Finish();
+ *
+ * Finish() completes the stream and flushes target too. The destructor
+ * finishes a stream left open, but any error is lost there, so call Finish()
+ * to see it. zlib errors throw std::runtime_error.
  */
-class   Text : public NodeInline
+class   DeflateSink : public Sink
 {
-public:
-    Text(std::string text)
-        : NodeInline("", text)
+    Sink                    &target;
+    z_stream                stream{};
+    std::vector<char>       input;
+    char                    output[16 * 1024];
+    std::size_t             compressed{0};
+    bool                    finished{false};
+
+    static void Fail(const char *operation, int result)
     {
-#ifdef __DEBUG
-        std::cout << "Constructing Text" << std::endl;
-#endif
+        throw std::runtime_error(std::string("simple_html::DeflateSink: ") + operation + " failed (" + std::to_string(result) + ")");
     }
 
-    virtual ~Text()
+    /// Compresses the buffered input; flush is Z_NO_FLUSH, Z_SYNC_FLUSH (see Flush()) or Z_FINISH.
+    void    Deflate(int flush)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Text" << std::endl;
-#endif
+        stream.next_in = reinterpret_cast<Bytef*>(base);
+        stream.avail_in = uInt(cursor - base);
+
+        int result;
+        do
+        {
+            stream.next_out = reinterpret_cast<Bytef*>(output);
+            stream.avail_out = uInt(sizeof(output));
+
+            result = ::deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR)
+            {
+                Fail("deflate", result);
+            }
+
+            std::size_t produced = sizeof(output) - stream.avail_out;
+            target.Write(output, produced);
+            compressed += produced;
+        }
+        while (stream.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+
+        flushed += std::size_t(cursor - base);
+        cursor = base;
     }
 
-    virtual std::string Get(int indentation = 0) override
+    void    Overflow(const char *data, std::size_t size) override
     {
-        std::stringstream   stream;
+        while (size > 0)
+        {
+            std::size_t part = std::min(size, std::size_t(limit - cursor));
 
-        WriteIdentation(stream, indentation);
-        stream << value;
+            std::memcpy(cursor, data, part);
+            cursor += part;
+            data += part;
+            size -= part;
 
-        return stream.str();
+            if (cursor == limit)
+            {
+                Deflate(Z_NO_FLUSH);
+            }
+        }
     }
-};
-
-inline  std::shared_ptr<Text>   GetText(std::string text)
-{
-    return std::make_shared<Text>(text);
-}
 
-//----------------------------------------------------------------------------
-/**
- * @brief The Span class handles a one-line Span node, <span></span>.
- */
-class   Span : public NodeInline
-{
 public:
-    Span()
-        : NodeInline("span")
+    DeflateSink(Sink &target, const DeflateOptions &options = DeflateOptions())
+        : target(target),
+          input(std::max<std::size_t>(options.buffer_size, 1024))
     {
-#ifdef __DEBUG
-       std:: cout << "Constructing Span" << std::endl;
-#endif
+        int window_bits = options.format == DeflateOptions::Gzip ? 15 + 16 : (options.format == DeflateOptions::Raw ? -15 : 15);
+        int result = ::deflateInit2(&stream, options.level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY);
+
+        if (result != Z_OK)
+        {
+            Fail("deflateInit2", result);
+        }
+
+        base = cursor = input.data();
+        limit = base + input.size();
+        layout = target.GetLayout();
     }
 
-    Span(std::string text)
-        : NodeInline("span", text)
+    DeflateSink(const DeflateSink &) = delete;
+    DeflateSink& operator=(const DeflateSink &) = delete;
+
+    virtual ~DeflateSink()
     {
-#ifdef __DEBUG
-       std:: cout << "Constructing Span" << std::endl;
-#endif
+        try
+        {
+            Finish();
+        }
+        catch (...)
+        {
+        }
+        ::deflateEnd(&stream);
     }
 
-    virtual ~Span()
+    /// Compresses what is buffered with Z_SYNC_FLUSH, so the target can decode everything written so far.
+    void    Flush() override
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Span" << std::endl;
-#endif
+        Deflate(Z_SYNC_FLUSH);
+        target.Flush();
+    }
+
+    /// Completes the compressed stream and flushes the target sink.
+    void    Finish()
+    {
+        if (!finished)
+        {
+            Deflate(Z_FINISH);
+            finished = true;
+            target.Flush();
+        }
     }
+
+    /// Uncompressed bytes written so far; the same as Size().
+    std::size_t UncompressedSize() const {return Size();}
+    /// Compressed bytes passed to the target so far.
+    std::size_t CompressedSize() const {return compressed;}
 };
+#endif
 
 //----------------------------------------------------------------------------
 /**
- * @brief The Div class handles a one-line Div node, <div></div>.
+ * @brief NeedsEscape tells if c must be replaced by an entity in text (&<>) or attribute values (&<>"').
  */
-class   Div : public NodeBase
+template<bool attribute>
+inline  bool    NeedsEscape(char c)
 {
-public:
-    Div()
-        : NodeBase("div")
+    return c == '&' || c == '<' || c == '>' || (attribute && (c == '"' || c == '\''));
+}
+
+/**
+ * @brief FindEscape returns the first character in [first, last) that needs escaping, or last.
+ *
+ * Clean input is scanned 32 (AVX2) or 16 (SSE2) bytes at a time; the scalar
+ * loop finishes the tail and locates the hit inside a flagged block.
+ */
+template<bool attribute>
+inline  const char* FindEscape(const char *first, const char *last)
+{
+#if defined(__AVX2__)
     {
-#ifdef __DEBUG
-       std:: cout << "Constructing Div" << std::endl;
-#endif
-    }
+        const __m256i   amp = _mm256_set1_epi8('&');
+        const __m256i   lt = _mm256_set1_epi8('<');
+        const __m256i   gt = _mm256_set1_epi8('>');
+        const __m256i   quot = _mm256_set1_epi8('"');
+        const __m256i   apos = _mm256_set1_epi8('\'');
 
-    virtual ~Div()
+        while (last - first >= 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+            __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(block, amp),
+                                          _mm256_or_si256(_mm256_cmpeq_epi8(block, lt), _mm256_cmpeq_epi8(block, gt)));
+            if (attribute)
+            {
+                hit = _mm256_or_si256(hit, _mm256_or_si256(_mm256_cmpeq_epi8(block, quot), _mm256_cmpeq_epi8(block, apos)));
+            }
+            if (_mm256_movemask_epi8(hit) != 0)
+            {
+                break;
+            }
+            first += 32;
+        }
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Div" << std::endl;
+        const __m128i   amp = _mm_set1_epi8('&');
+        const __m128i   lt = _mm_set1_epi8('<');
+        const __m128i   gt = _mm_set1_epi8('>');
+        const __m128i   quot = _mm_set1_epi8('"');
+        const __m128i   apos = _mm_set1_epi8('\'');
+
+        while (last - first >= 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+            __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(block, amp),
+                                       _mm_or_si128(_mm_cmpeq_epi8(block, lt), _mm_cmpeq_epi8(block, gt)));
+            if (attribute)
+            {
+                hit = _mm_or_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(block, quot), _mm_cmpeq_epi8(block, apos)));
+            }
+            if (_mm_movemask_epi8(hit) != 0)
+            {
+                break;
+            }
+            first += 16;
+        }
+    }
 #endif
+    while (first != last && !NeedsEscape<attribute>(*first))
+    {
+        ++first;
     }
-};
 
-//----------------------------------------------------------------------------
+    return first;
+}
+
 /**
- * @brief The Sub class handles a one-line subscript node, <sub></sub>.
+ * @brief WriteEscaped writes text to sink, copying clean runs in bulk and replacing special characters by entities.
  */
-class   SubScript : public NodeInline
+template<bool attribute>
+inline  void    WriteEscaped(Sink &sink, std::string_view text)
 {
-public:
-    SubScript()
-        : NodeInline("sub")
-    {
-#ifdef __DEBUG
-       std:: cout << "Constructing SubScript" << std::endl;
-#endif
-    }
+    const char  *first = text.data();
+    const char  *last = first + text.size();
 
-    SubScript(std::string text)
-        : NodeInline("sub", text)
+    while (true)
     {
-#ifdef __DEBUG
-       std:: cout << "Constructing SubScript" << std::endl;
-#endif
+        const char  *special = FindEscape<attribute>(first, last);
+        sink.Write(first, std::size_t(special - first));
+
+        if (special == last)
+        {
+            break;
+        }
+
+        switch (*special)
+        {
+        case '&':   sink.Write("&amp;", 5);     break;
+        case '<':   sink.Write("&lt;", 4);      break;
+        case '>':   sink.Write("&gt;", 4);      break;
+        case '"':   sink.Write("&quot;", 6);    break;
+        default:    sink.Write("&#39;", 5);     break;
+        }
+
+        first = special + 1;
     }
+}
 
-    virtual ~SubScript()
+/**
+ * @brief EscapedSize returns the number of bytes WriteEscaped() writes for text.
+ */
+template<bool attribute>
+inline  std::size_t EscapedSize(std::string_view text)
+{
+    const char  *first = text.data();
+    const char  *last = first + text.size();
+    std::size_t size = text.size();
+
+    while ((first = FindEscape<attribute>(first, last)) != last)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing SubScript" << std::endl;
-#endif
+        size += (*first == '<' || *first == '>') ? 3 : (*first == '"' ? 5 : 4);
+        ++first;
     }
-};
 
-inline  std::shared_ptr<SubScript>   GetSubScript()
+    return size;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief WriteNumber formats value straight into sink, see FormatNumber().
+ */
+template<typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer>>>
+inline  void    WriteNumber(Sink &sink, Integer value)
 {
-    return std::make_shared<SubScript>();
+    char    buffer[number_buffer_size];
+
+    sink.Write(buffer, std::size_t(FormatNumber(buffer, value) - buffer));
 }
 
-inline  std::shared_ptr<SubScript>   GetSubScript(std::string text)
+inline  void    WriteNumber(Sink &sink, double value, const NumberFormat &format = NumberFormat())
+{
+    char    buffer[number_buffer_size];
+
+    sink.Write(buffer, std::size_t(FormatNumber(buffer, value, format) - buffer));
+}
+
+/**
+ * @brief NumberSize returns the number of bytes WriteNumber() writes for value.
+ */
+template<typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer>>>
+inline  std::size_t NumberSize(Integer value)
+{
+    char    buffer[number_buffer_size];
+
+    return std::size_t(FormatNumber(buffer, value) - buffer);
+}
+
+inline  std::size_t NumberSize(double value, const NumberFormat &format = NumberFormat())
 {
-    return std::make_shared<SubScript>(text);
+    char    buffer[number_buffer_size];
+
+    return std::size_t(FormatNumber(buffer, value, format) - buffer);
 }
 
 //----------------------------------------------------------------------------
 /**
- * @brief The Sup class handles a one-line superscript node, <sup></sup>.
+ * @brief HashMix scrambles the bits of h (the MurmurHash3 finalizer).
  */
-class   SuperScript : public NodeInline
+inline  std::uint64_t   HashMix(std::uint64_t h)
 {
-public:
-    SuperScript()
-        : NodeInline("sup")
-    {
-#ifdef __DEBUG
-       std:: cout << "Constructing SuperScript" << std::endl;
-#endif
-    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
 
-    SuperScript(std::string text)
-        : NodeInline("sup", text)
-    {
-#ifdef __DEBUG
-       std:: cout << "Constructing SuperScript" << std::endl;
-#endif
-    }
+    return h;
+}
 
-    virtual ~SuperScript()
+/**
+ * @brief HashBytes continues the 64-bit hash seed over size bytes at data, eight bytes at a time.
+ */
+inline  std::uint64_t   HashBytes(std::uint64_t seed, const void *data, std::size_t size)
+{
+    const char      *p = static_cast<const char*>(data);
+    std::uint64_t   h = HashMix(seed ^ (size * 0x9e3779b97f4a7c15ULL));
+    std::uint64_t   word;
+
+    for (; size >= 8; p += 8, size -= 8)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing SuperScript" << std::endl;
-#endif
+        std::memcpy(&word, p, 8);
+        h = HashMix(h ^ word);
     }
-};
 
-inline  std::shared_ptr<SuperScript>   GetSuperScript()
-{
-    return std::make_shared<SuperScript>();
+    word = 0;
+    std::memcpy(&word, p, size);
+
+    return HashMix(h ^ word);
 }
 
-inline  std::shared_ptr<SuperScript>   GetSuperScript(std::string text)
+inline  std::uint64_t   HashBytes(std::uint64_t seed, std::string_view text)
 {
-    return std::make_shared<SuperScript>(text);
+    return HashBytes(seed, text.data(), text.size());
 }
 
 //----------------------------------------------------------------------------
 /**
- * @brief The Paragraph class handles a pragraph node, <p></p>.
+ * @brief The ParallelOptions class controls NodeBase::WriteParallel().
  */
-class   Paragraph : public NodeBase
+class   ParallelOptions
 {
 public:
-    Paragraph()
-        : NodeBase("p", "")
-    {
-#ifdef __DEBUG
-       std:: cout << "Constructing Paragraph" << std::endl;
-#endif
-    }
+    /// Number of threads to use, including the calling thread.
+    unsigned    threads{std::max(1u, std::thread::hardware_concurrency())};
+    /// Nodes with fewer children than this are serialized serially.
+    std::size_t threshold{256};
+};
 
-    Paragraph(std::string text)
-        : NodeBase("p", text)
+class   NodeBase;
+class   StreamWriter;
+class   Template;
+class   HtmlParser;
+class   Patch;
+class   NodeInterner;
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The NodeIndex class maps ids and class names to the nodes of a Document.
+ *
+ * Nodes are added as they are appended to the document and as they get id and
+ * class attributes; see Document::FindById() and Document::FindByClass().
+ */
+class   NodeIndex
+{
+    std::unordered_map<std::string, NodeBase*>                  ids;
+    std::unordered_map<std::string, std::vector<NodeBase*>>     classes;
+    std::vector<std::string>                                    duplicate_ids;
+    const std::vector<NodeBase*>                                none;
+
+public:
+    void    AddId(const std::string &id, NodeBase *node)
     {
-#ifdef __DEBUG
-       std:: cout << "Constructing Paragraph" << std::endl;
-#endif
+        auto    inserted = ids.emplace(id, node);
+
+        if (!inserted.second && std::find(duplicate_ids.begin(), duplicate_ids.end(), id) == duplicate_ids.end())
+        {
+            duplicate_ids.push_back(id);
+        }
     }
 
-    virtual ~Paragraph()
+    /// Adds node under each of the space separated names.
+    void    AddClasses(std::string_view names, NodeBase *node)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Paragraph" << std::endl;
-#endif
+        const char  *separators = " \t\n\r\f";
+        std::size_t first = names.find_first_not_of(separators);
+
+        while (first != std::string_view::npos)
+        {
+            std::size_t last = std::min(names.find_first_of(separators, first), names.size());
+
+            classes[std::string(names.substr(first, last - first))].push_back(node);
+            first = names.find_first_not_of(separators, last);
+        }
     }
 
-    std::shared_ptr<NodeBase>   AppendText(std::string text)
+    NodeBase*   FindById(const std::string &id) const
     {
-        return AppendChild(std::make_shared<Text>(text));
+        auto    found = ids.find(id);
+
+        return found == ids.end() ? nullptr : found->second;
     }
-};
 
-inline  std::shared_ptr<Paragraph>   GetParagraph()
-{
-    return std::make_shared<Paragraph>();
-}
+    const std::vector<NodeBase*>&   FindByClass(const std::string &class_name) const
+    {
+        auto    found = classes.find(class_name);
 
-inline  std::shared_ptr<Paragraph>   GetParagraph(std::string text)
-{
-    return std::make_shared<Paragraph>(text);
-}
+        return found == classes.end() ? none : found->second;
+    }
+
+    const std::vector<std::string>& DuplicateIds() const {return duplicate_ids;}
+};
 
+//----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 /**
- * @brief The ListItem class handles a one-line list item node, <li></li>.
+ * @brief The NodeBase class is a base class for nodes.
  */
-class   ListItem : public NodeBase
+class   NodeBase
 {
-public:
-    ListItem()
-        : NodeBase("li")
+protected:
+    const TagName   *tag;
+    std::string value;
+    bool        _is_inline{false};
+
+    bool        _renders_children{true};
+
+    // Incremental rendering, see GetCached(). parent is the node this one was
+    // first appended to; only that parent is notified of changes. Frozen nodes
+    // have none.
+    NodeBase    *parent{nullptr};
+    bool        dirty{true};
+
+    // Subtree hash, see Hash(); invalidated together with the cache.
+    std::uint64_t   hash{0};
+    bool            hash_valid{false};
+
+    // The index of the Document this node was first appended into, if any.
+    NodeIndex   *index{nullptr};
+
+    // The span of this node's output from the last GetCached(): cache_size
+    // bytes at cache_offset within the output of cache_owner, which is the
+    // parent it was written under or, for the node GetCached() was called on,
+    // the node itself. Only that root keeps the output bytes, in cache.
+    NodeBase    *cache_owner{nullptr};
+    std::size_t cache_offset{0};
+    std::size_t cache_size{0};
+    int         cache_indentation{-1};
+    Layout      cache_layout;
+    std::string cache;
+    // Set while GetCached() has entered the node and not yet left its parent,
+    // to tell a child appended twice to one parent from a single occurrence.
+    bool        cache_entered{false};
+
+    // Frozen subtrees, see Freeze(). The output for the first few indentation
+    // levels of the default layout, and the minified output, is published
+    // through atomic pointers and never changes again.
+    class   FrozenCache
     {
-#ifdef __DEBUG
-        std::cout << "Constructing ListItem" << std::endl;
+    public:
+        static const int    levels = 16;
+
+        std::atomic<const std::string*> output[levels] = {};
+        std::atomic<const std::string*> minified{nullptr};
+
+        ~FrozenCache()
+        {
+            for (auto &o : output)
+            {
+                delete o.load();
+            }
+            delete minified.load();
+        }
+    };
+
+    bool        frozen{false};
+    std::atomic<FrozenCache*>   frozen_cache{nullptr};
+
+    /// Returns the output of a frozen node at indentation, computing it on first use; nullptr if not cached.
+    const std::string*  FrozenOutput(const Layout &layout, int indentation)
+    {
+        bool    minified = layout == Layout::Minified();
+
+        if (!minified && (layout != Layout() || indentation < 0 || indentation >= FrozenCache::levels))
+        {
+            return nullptr;
+        }
+
+        FrozenCache *levels = frozen_cache.load(std::memory_order_acquire);
+        if (levels == nullptr)
+        {
+            FrozenCache *created = new FrozenCache();
+            if (frozen_cache.compare_exchange_strong(levels, created, std::memory_order_acq_rel))
+            {
+                levels = created;
+            }
+            else
+            {
+                delete created;
+            }
+        }
+
+        std::atomic<const std::string*> &slot = minified ? levels->minified : levels->output[indentation];
+        const std::string   *output = slot.load(std::memory_order_acquire);
+        if (output == nullptr)
+        {
+            std::string *rendered = new std::string();
+#ifdef SIMPLE_HTML_PROFILE
+            if (Profiler *profiler = CurrentProfiler())
+            {
+                profiler->Allocation();
+            }
 #endif
+            {
+                StringSink  sink(*rendered);
+                sink.SetLayout(layout);
+                WriteNodes(sink, indentation, false);
+            }
+
+            // Threads racing here render the same bytes; the first one wins.
+            if (slot.compare_exchange_strong(output, rendered, std::memory_order_acq_rel))
+            {
+                output = rendered;
+            }
+            else
+            {
+                delete rendered;
+            }
+        }
+
+        return output;
     }
 
-    ListItem(std::string text)
-        : NodeBase("li", text)
+    /// Marks the node and its ancestors as changed; throws std::logic_error if the node is frozen.
+    void    Touch()
     {
-#ifdef __DEBUG
-        std::cout << "Constructing ListItem" << std::endl;
-#endif
+        if (frozen)
+        {
+            throw std::logic_error("simple_html: node is frozen");
+        }
+
+        for (NodeBase *node = this; node != nullptr && (!node->dirty || node->hash_valid); node = node->parent)
+        {
+            node->dirty = true;
+            node->hash_valid = false;
+        }
     }
 
-    virtual ~ListItem()
+    /// Hash of content a subclass writes from elsewhere than value, attributes and children.
+    virtual std::uint64_t   HashContent()
     {
-#ifdef __DEBUG
-        std::cout << "Destructing ListItem" << std::endl;
-#endif
+        return 0;
     }
-};
 
-//----------------------------------------------------------------------------
-/**
- * @brief The UnorderedList class handles an unordered list, <ul></ul>.
- */
-class   UnorderedList : public NodeBase
-{
-public:
-    UnorderedList()
-        : NodeBase("ul")
+    /// Hash of the node itself, without its children.
+    std::uint64_t   NodeHash()
     {
-#ifdef __DEBUG
-        std::cout << "Constructing UnorderedList" << std::endl;
-#endif
+        std::uint64_t   h = HashBytes(typeid(*this).hash_code(), tag->name);
+
+        h = HashBytes(h ^ (_is_inline ? 1 : 2) ^ (_renders_children ? 4 : 8), value);
+        for (std::size_t i = 0; i < attributes.size(); ++i)
+        {
+            const AttributeEntry    &a = attributes[i];
+
+            h = HashBytes(h ^ a.kind, a.name->name);
+            switch (a.kind)
+            {
+            case AttributeEntry::Integer:   h = HashMix(h ^ std::uint64_t(a.integer));      break;
+            case AttributeEntry::Number:    h = HashBytes(h ^ std::uint64_t(a.format.precision), &a.number, sizeof(a.number));  break;
+            default:                        h = HashBytes(h, a.value);                      break;
+            }
+        }
+
+        return HashMix(h ^ HashContent());
     }
 
-    virtual ~UnorderedList()
+    Sink&   StartTag(Sink &sink)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing UnorderedList" << std::endl;
-#endif
+        if (attributes.empty())
+        {
+            sink.Write(tag->open.data(), tag->open.size());
+            return sink;
+        }
+
+        sink.Write(tag->open.data(), tag->open.size() - 1);
+
+        for (std::size_t i = 0; i < attributes.size(); ++i)
+        {
+            const AttributeEntry    &a = attributes[i];
+
+            sink.Write(a.name->prefix);
+            switch (a.kind)
+            {
+            case AttributeEntry::Text:          WriteEscaped<true>(sink, a.value);                  break;
+            case AttributeEntry::Integer:       WriteNumber(sink, a.integer);                       break;
+            case AttributeEntry::Number:        WriteNumber(sink, a.number, a.format);              break;
+            case AttributeEntry::TemplateSlot:  sink.WriteSlot(Sink::AttributeSlot, a.value, 0, 0);    break;
+            }
+            sink.Put('"');
+        }
+
+        sink.Put('>');
+
+        return sink;
     }
-};
 
-//----------------------------------------------------------------------------
-/**
- * @brief The OrderedList class handles an ordered list, <ol></ol>.
- */
-class   OrderedList : public NodeBase
-{
-public:
-    OrderedList()
-        : NodeBase("ol")
+    virtual Sink&   EndTag(Sink &sink)
     {
-#ifdef __DEBUG
-        std::cout << "Constructing OrderedList" << std::endl;
-#endif
+        sink.Write(tag->close.data(), tag->close.size());
+
+        return sink;
     }
 
-    virtual ~OrderedList()
+    std::size_t StartTagSize()
     {
-#ifdef __DEBUG
-        std::cout << "Destructing OrderedList" << std::endl;
-#endif
+        std::size_t size = tag->open.size();
+
+        for (std::size_t i = 0; i < attributes.size(); ++i)
+        {
+            const AttributeEntry    &a = attributes[i];
+
+            size += a.name->prefix.size() + 1;
+            switch (a.kind)
+            {
+            case AttributeEntry::Text:          size += EscapedSize<true>(a.value);         break;
+            case AttributeEntry::Integer:       size += NumberSize(a.integer);              break;
+            case AttributeEntry::Number:        size += NumberSize(a.number, a.format);     break;
+            case AttributeEntry::TemplateSlot:  break;
+            }
+        }
+
+        return size;
     }
-};
 
-//----------------------------------------------------------------------------
-/**
- * @brief The Table class  handles an ordered list, <table></table>.
- */
-class   Table : public NodeBase
-{
-public:
-    Table()
-        : NodeBase("table")
+    virtual std::size_t EndTagSize()
     {
-#ifdef __DEBUG
-        std::cout << "Constructing Table" << std::endl;
-#endif
+        return tag->close.size();
     }
 
-    Table(std::string caption)
-        : NodeBase("table")
+    Sink&   WriteIdentation(Sink &sink, int indentation)
     {
-        AppendChild(std::make_shared<NodeBase>("caption", caption));
-#ifdef __DEBUG
-        std::cout << "Constructing Table" << std::endl;
-#endif
+        if (!this->is_inline())
+        {
+            sink.Indent(indentation);
+        }
+
+        return sink;
     }
 
-    virtual ~Table()
+    std::size_t IdentationSize(const Layout &layout, int indentation)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing Table" << std::endl;
-#endif
+        return this->is_inline() ? 0 : layout.IndentSize(indentation);
     }
-};
 
-//----------------------------------------------------------------------------
-/**
- * @brief The TableRow class handles a table row, <tr></tr>.
- */
-class   TableRow : public NodeBase
-{
-public:
-    TableRow()
-        : NodeBase("tr")
+    /// Writes everything up to the first child: indentation, start tag and value.
+    virtual void    WriteOpen(Sink &sink, int indentation)
     {
-#ifdef __DEBUG
-        std::cout << "Constructing TableRow" << std::endl;
-#endif
+        WriteIdentation(sink, indentation);
+        StartTag(sink);
+
+        if (value.length() > 0)
+        {
+            sink.Newline();
+            sink.Indent(indentation + 1);
+            WriteEscaped<false>(sink, value);
+        }
     }
 
-    virtual ~TableRow()
+    /// Writes what goes in front of a child.
+    virtual void    WriteSeparator(Sink &sink, NodeBase &child)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing TableRow" << std::endl;
-#endif
+        if (!child.is_inline())
+        {
+            sink.Newline();
+        }
     }
-};
 
-//----------------------------------------------------------------------------
-/**
- * @brief The TableElement class handles a one-line table element node, i.e. cell, <td>text</td>.
- */
-class   TableElement : public NodeLine
-{
-public:
-    TableElement()
-        : NodeLine("td")
+    /// Writes everything after the last child.
+    virtual void    WriteClose(Sink &sink, int indentation)
     {
-#ifdef __DEBUG
-        std::cout << "Constructing TableElement" << std::endl;
-#endif
+        sink.Newline();
+        sink.Indent(indentation);
+        EndTag(sink);
     }
 
-    TableElement(std::string text)
-        : NodeLine("td", text)
+    /// The number of bytes WriteOpen() writes.
+    virtual std::size_t OpenSize(const Layout &layout, int indentation)
     {
-#ifdef __DEBUG
-        std::cout << "Constructing TableElement" << std::endl;
-#endif
+        std::size_t size = IdentationSize(layout, indentation) + StartTagSize();
+
+        if (value.length() > 0)
+        {
+            size += layout.NewlineSize() + layout.IndentSize(indentation + 1) + EscapedSize<false>(value);
+        }
+
+        return size;
     }
 
-    virtual ~TableElement()
+    /// The number of bytes WriteSeparator() writes.
+    virtual std::size_t SeparatorSize(const Layout &layout, NodeBase &child)
     {
-#ifdef __DEBUG
-        std::cout << "Destructing TableElement" << std::endl;
-#endif
+        return child.is_inline() ? 0 : layout.NewlineSize();
     }
-};
 
-//----------------------------------------------------------------------------
-/**
- * @brief The TableHeaderElement class handles a one line table header element node, <th>text</th>.
- */
-class   TableHeaderElement : public NodeLine
-{
-public:
-    TableHeaderElement()
-        : NodeLine("th")
+    /// The number of bytes WriteClose() writes.
+    virtual std::size_t CloseSize(const Layout &layout, int indentation)
     {
-#ifdef __DEBUG
-        std::cout << "Constructing TableHeaderElement" << std::endl;
-#endif
+        return layout.NewlineSize() + layout.IndentSize(indentation) + EndTagSize();
     }
 
-    TableHeaderElement(std::string text)
-        : NodeLine("th", text)
+    std::vector<std::shared_ptr<NodeBase>>  children;
+    AttributeList   attributes;
+public:
+    NodeBase(const TagName &tag)
+        : tag(&tag),
+          value("")
     {
 #ifdef __DEBUG
-        std::cout << "Constructing TableHeaderElement" << std::endl;
+        std::cout << "Constructing NodeBase" << std::endl;
 #endif
     }
-
-    virtual ~TableHeaderElement()
+    NodeBase(const TagName &tag, std::string value)
+        : tag(&tag),
+          value(std::move(value))
     {
 #ifdef __DEBUG
-        std::cout << "Destructing TableHeaderElement" << std::endl;
+        std::cout << "Constructing NodeBase" << std::endl;
 #endif
     }
+    NodeBase(std::string name)
+        : NodeBase(InternTagName(name))
+    {
+    }
+    NodeBase(std::string name, std::string value)
+        : NodeBase(InternTagName(name), std::move(value))
+    {
+    }
+
+    virtual ~NodeBase()
+    {
+        // Children that are only owned by this subtree are taken apart level by
+        // level on an explicit stack, so destroying a deep tree does not recurse.
+        std::vector<std::shared_ptr<NodeBase>>  pending;
+
+        Release(pending);
+        while (!pending.empty())
+        {
+            std::shared_ptr<NodeBase>   node = std::move(pending.back());
+            pending.pop_back();
+
+            if (node.use_count() == 1)
+            {
+                node->Release(pending);
+            }
+        }
+        delete frozen_cache.load();
+#ifdef __DEBUG
+        std::cout << "Destructing NodeBase" << std::endl;
+#endif
+    }
+
+    std::shared_ptr<Attribute>    AppendAttribute(const std::shared_ptr<Attribute> &a)
+    {
+        Touch();
+        IndexAttribute(attributes.Append(InternAttributeName(a->name), a->Value()));
+        return a;
+    }
+
+    NodeBase&   AppendAttribute(const std::string &name, std::string value)
+    {
+        Touch();
+        IndexAttribute(attributes.Append(InternAttributeName(name), std::move(value)));
+        return *this;
+    }
+
+    /// Appends a numeric attribute; the value is formatted when the node is written.
+    template<typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer>>>
+    NodeBase&   AppendAttribute(const std::string &name, Integer value)
+    {
+        Touch();
+        AttributeEntry  &entry = attributes.Append(InternAttributeName(name), std::string());
+        entry.kind = AttributeEntry::Integer;
+        entry.integer = std::int64_t(value);
+        IndexAttribute(entry);
+        return *this;
+    }
+
+    NodeBase&   AppendAttribute(const std::string &name, double value, NumberFormat format = NumberFormat())
+    {
+        Touch();
+        AttributeEntry  &entry = attributes.Append(InternAttributeName(name), std::string());
+        entry.kind = AttributeEntry::Number;
+        entry.number = value;
+        entry.format = format;
+        IndexAttribute(entry);
+        return *this;
+    }
+
+    /// Appends an attribute whose value is filled in by a Template, see Slot.
+    NodeBase&   AppendAttributeSlot(const std::string &name, std::string slot)
+    {
+        Touch();
+        AttributeEntry  &entry = attributes.Append(InternAttributeName(name), std::move(slot));
+        entry.kind = AttributeEntry::TemplateSlot;
+        return *this;
+    }
+
+    std::shared_ptr<NodeBase>    AppendChild(const std::shared_ptr<NodeBase> &a)
+    {
+        Touch();
+        // Frozen nodes may be read by other threads, so they are never written to.
+        if (!a->frozen && a->parent == nullptr)
+        {
+            a->parent = this;
+        }
+        children.push_back(a);
+        if (index != nullptr)
+        {
+            a->AddToIndex(*index);
+        }
+        return a;
+    }
+
+    void    SetValue(std::string value)
+    {
+        Touch();
+        this->value = std::move(value);
+    }
+
+    NodeBase&   AppendId(std::string id)
+    {
+        return AppendAttribute("id", std::move(id));
+    }
+
+    NodeBase&   AppendClass(std::string name)
+    {
+        return AppendAttribute("class", std::move(name));
+    }
+
+protected:
+    /// Adds entry to target if it is an id or class attribute of node.
+    static void AddAttributeToIndex(NodeIndex &target, NodeBase &node, const AttributeEntry &entry)
+    {
+        // A slot's value is the slot name; the id or class is only known when a Template renders it.
+        if (entry.kind == AttributeEntry::TemplateSlot)
+        {
+            return;
+        }
+
+        if (entry.name->name == "id")
+        {
+            char    number[number_buffer_size];
+
+            switch (entry.kind)
+            {
+            case AttributeEntry::Integer:   target.AddId(std::to_string(entry.integer), &node);     break;
+            case AttributeEntry::Number:    target.AddId(std::string(number, FormatNumber(number, entry.number, entry.format)), &node);     break;
+            default:                        target.AddId(entry.value, &node);                       break;
+            }
+        }
+        else if (entry.name->name == "class" && entry.kind == AttributeEntry::Text)
+        {
+            target.AddClasses(entry.value, &node);
+        }
+    }
+
+    /// Adds an attribute that was just appended to the index of the document, if any.
+    void    IndexAttribute(const AttributeEntry &entry)
+    {
+        if (index != nullptr)
+        {
+            AddAttributeToIndex(*index, *this, entry);
+        }
+    }
+
+    /// Calls visit(node) for the subtree in document order; children are skipped where it returns false.
+    template<typename Function>
+    void    ForEachNode(Function visit)
+    {
+        std::vector<NodeBase*>  pending{this};
+
+        while (!pending.empty())
+        {
+            NodeBase    *node = pending.back();
+            pending.pop_back();
+
+            if (visit(*node))
+            {
+                for (auto c = node->children.rbegin(); c != node->children.rend(); ++c)
+                {
+                    pending.push_back(c->get());
+                }
+            }
+        }
+    }
+
+    /// Adds the ids and classes of the subtree to target; nodes not yet in a document are tied to it.
+    void    AddToIndex(NodeIndex &target)
+    {
+        ForEachNode([&target](NodeBase &node)
+        {
+            // Frozen nodes cannot change any more and may be read by other threads.
+            if (!node.frozen && node.index == nullptr)
+            {
+                node.index = &target;
+            }
+
+            for (std::size_t i = 0; i < node.attributes.size(); ++i)
+            {
+                AddAttributeToIndex(target, node, node.attributes[i]);
+            }
+            return true;
+        });
+    }
+
+    /// Unties the subtree from target, which is about to be destroyed.
+    void    DetachFromIndex(NodeIndex &target)
+    {
+        ForEachNode([&target](NodeBase &node)
+        {
+            if (node.frozen)
+            {
+                return false;
+            }
+            if (node.index == &target)
+            {
+                node.index = nullptr;
+            }
+            return true;
+        });
+    }
+
+    /// Moves the children to pending, detaching them from this node.
+    void    Release(std::vector<std::shared_ptr<NodeBase>> &pending)
+    {
+        for (auto &c : children)
+        {
+            if (!c->frozen && c->parent == this)
+            {
+                c->parent = nullptr;
+            }
+            pending.push_back(std::move(c));
+        }
+        children.clear();
+    }
+
+    /// What Traverse() does after Visitor::Enter().
+    enum    Visit
+    {
+        VisitChildren,  ///< Visit the rendered children, then call Leave().
+        SkipChildren,   ///< Call Leave() without visiting the children.
+        SkipNode        ///< Neither visit the children nor call Leave().
+    };
+
+    /**
+     * @brief Traverse walks the subtree in document order with an explicit stack.
+     *
+     * For every node the visitor gets Enter(node, indentation), then for each
+     * rendered child Separator(node, child) followed by the child's visit, and
+     * finally Leave(node, indentation). Stack usage does not depend on depth.
+     */
+    template<typename Visitor>
+    void    Traverse(Visitor &visitor, int indentation)
+    {
+        class   Frame
+        {
+        public:
+            NodeBase    *node;
+            std::size_t next;
+            int         indentation;
+        };
+
+        std::vector<Frame>  stack;
+
+        auto    enter = [&visitor, &stack](NodeBase &node, int indentation)
+        {
+            switch (visitor.Enter(node, indentation))
+            {
+            case VisitChildren:
+                if (node._renders_children && !node.children.empty())
+                {
+                    stack.push_back({&node, 0, indentation});
+                    break;
+                }
+                visitor.Leave(node, indentation);
+                break;
+            case SkipChildren:
+                visitor.Leave(node, indentation);
+                break;
+            case SkipNode:
+                break;
+            }
+        };
+
+        enter(*this, indentation);
+
+        while (!stack.empty())
+        {
+            Frame   &frame = stack.back();
+
+            if (frame.next < frame.node->children.size())
+            {
+                NodeBase    &parent = *frame.node;
+                NodeBase    &child = *parent.children[frame.next++];
+
+                visitor.Separator(parent, child);
+                enter(child, frame.indentation + 1);
+            }
+            else
+            {
+                NodeBase    &node = *frame.node;
+                int         node_indentation = frame.indentation;
+
+                stack.pop_back();
+                visitor.Leave(node, node_indentation);
+            }
+        }
+    }
+
+    /// Writes the children of a wide node in parallel, see WriteParallel().
+    void    WriteChildrenParallel(Sink &sink, const ParallelOptions &options, int indentation)
+    {
+        std::size_t parts = std::min<std::size_t>(options.threads, children.size());
+        std::vector<std::string>        buffers(parts);
+        std::vector<std::future<void>>  tasks;
+
+        auto    write_range = [this, &sink, &buffers, parts, indentation](std::size_t part)
+        {
+            std::size_t first = children.size() * part / parts;
+            std::size_t last = children.size() * (part + 1) / parts;
+            StringSink  range_sink(buffers[part]);
+
+            range_sink.SetLayout(sink.GetLayout());
+            for (std::size_t i = first; i < last; ++i)
+            {
+                WriteSeparator(range_sink, *children[i]);
+                children[i]->Write(range_sink, indentation + 1);
+            }
+        };
+
+        for (std::size_t part = 1; part < parts; ++part)
+        {
+            tasks.push_back(std::async(std::launch::async, write_range, part));
+        }
+        write_range(0);
+
+        for (auto &t : tasks)
+        {
+            t.get();
+        }
+        for (auto &b : buffers)
+        {
+            sink.Write(b);
+        }
+    }
+
+    /// Writes the subtree, taking frozen subtrees from their caches if use_frozen is set.
+    void    WriteNodes(Sink &sink, int indentation, bool use_frozen)
+    {
+        class   Writer
+        {
+        public:
+            Sink    &sink;
+            bool    use_frozen;
+#ifdef SIMPLE_HTML_PROFILE
+            // Cache fills (use_frozen unset) are not reported as nodes.
+            Profiler    *profiler{use_frozen ? CurrentProfiler() : nullptr};
+#endif
+
+            Visit   Enter(NodeBase &node, int indentation)
+            {
+                if (use_frozen && node.frozen)
+                {
+                    if (const std::string *output = node.FrozenOutput(sink.GetLayout(), indentation))
+                    {
+#ifdef SIMPLE_HTML_PROFILE
+                        if (profiler != nullptr)
+                        {
+                            profiler->Cached(typeid(node), sink.Size(), output->size());
+                        }
+#endif
+                        sink.Write(*output);
+                        return SkipNode;
+                    }
+                }
+
+#ifdef SIMPLE_HTML_PROFILE
+                if (profiler != nullptr)
+                {
+                    profiler->Enter(typeid(node), sink.Size());
+                }
+#endif
+                node.WriteOpen(sink, indentation);
+                return VisitChildren;
+            }
+
+            void    Separator(NodeBase &parent, NodeBase &child)
+            {
+                std::size_t start = sink.Size();
+
+                parent.WriteSeparator(sink, child);
+                sink.EndSeparator(start);
+            }
+
+            void    Leave(NodeBase &node, int indentation)
+            {
+                node.WriteClose(sink, indentation);
+#ifdef SIMPLE_HTML_PROFILE
+                if (profiler != nullptr)
+                {
+                    profiler->Leave(sink.Size());
+                }
+#endif
+            }
+        };
+
+        Writer  writer{sink, use_frozen};
+        Traverse(writer, indentation);
+    }
+
+public:
+    /**
+     * @brief Write serializes the node and its children into sink in a single pass.
+     */
+    void    Write(Sink &sink, int indentation = 0)
+    {
+        WriteNodes(sink, indentation, true);
+    }
+
+    std::string Get(int indentation = 0)
+    {
+        return Get(Layout(), indentation);
+    }
+
+    /**
+     * @brief Get returns the node serialized with the given layout, e.g. Get(Layout::Minified()).
+     */
+    std::string Get(const Layout &layout, int indentation = 0)
+    {
+        std::string result;
+        StringSink  sink(result);
+
+        sink.SetLayout(layout);
+        Write(sink, indentation);
+        sink.Flush();
+
+        return result;
+    }
+
+    /**
+     * @brief WriteParallel serializes like Write(), splitting wide nodes across threads.
+     *
+     * The children of a node with at least options.threshold children are
+     * divided into one contiguous range per thread; each range is serialized
+     * into its own buffer and the buffers are written to sink in order, so the
+     * output is byte-identical to Write(). The tree must not be modified while
+     * it is being written.
+     */
+    void    WriteParallel(Sink &sink, const ParallelOptions &options, int indentation = 0)
+    {
+        class   ParallelWriter
+        {
+        public:
+            Sink                    &sink;
+            const ParallelOptions   &options;
+
+            Visit   Enter(NodeBase &node, int indentation)
+            {
+                if (node.frozen)
+                {
+                    if (const std::string *output = node.FrozenOutput(sink.GetLayout(), indentation))
+                    {
+                        sink.Write(*output);
+                        return SkipNode;
+                    }
+                }
+
+                node.WriteOpen(sink, indentation);
+
+                if (node._renders_children && options.threads > 1 &&
+                    node.children.size() >= std::max<std::size_t>(options.threshold, 2))
+                {
+                    node.WriteChildrenParallel(sink, options, indentation);
+                    return SkipChildren;
+                }
+
+                return VisitChildren;
+            }
+
+            void    Separator(NodeBase &parent, NodeBase &child)
+            {
+                parent.WriteSeparator(sink, child);
+            }
+
+            void    Leave(NodeBase &node, int indentation)
+            {
+                node.WriteClose(sink, indentation);
+            }
+        };
+
+        ParallelWriter  writer{sink, options};
+        Traverse(writer, indentation);
+    }
+
+    std::string GetParallel(const ParallelOptions &options = ParallelOptions(), int indentation = 0)
+    {
+        return GetParallel(Layout(), options, indentation);
+    }
+
+    /**
+     * @brief GetParallel returns the same as Get(layout, indentation), see WriteParallel().
+     */
+    std::string GetParallel(const Layout &layout, const ParallelOptions &options = ParallelOptions(), int indentation = 0)
+    {
+        std::string result;
+        StringSink  sink(result);
+
+        sink.SetLayout(layout);
+        WriteParallel(sink, options, indentation);
+        sink.Flush();
+
+        return result;
+    }
+
+    /**
+     * @brief GetCached returns the same as Get(), reusing the output of unchanged subtrees.
+     *
+     * The node keeps its last output, and every node with children below it
+     * the position of its own output within that of its parent, so the memory
+     * used is one copy of the output whatever the depth of the tree. Changes
+     * made through AppendChild(),
+     * AppendAttribute(), AppendId(), AppendClass() and SetValue() mark the node
+     * and its ancestors dirty, so the next call only re-serializes the changed
+     * paths. A subtree containing a node shared with another parent is never
+     * cached, because only the first parent is notified of its changes.
+     */
+    std::string GetCached(int indentation = 0)
+    {
+        return GetCached(Layout(), indentation);
+    }
+
+    std::string GetCached(const Layout &layout, int indentation = 0)
+    {
+        std::string result;
+
+        {
+            StringSink  sink(result);
+
+            sink.SetLayout(layout);
+            WriteCached(sink, indentation);
+        }
+
+        if (cache_owner == this)
+        {
+            cache = result;
+        }
+
+        return result;
+    }
+
+    bool    is_dirty() {return dirty;}
+
+    /**
+     * @brief Hash returns a 64-bit hash of the subtree: node types, tags, values, attributes and children.
+     *
+     * Equal subtrees of the same node classes hash equal. The class is part of
+     * the hash because it decides how a node is written, so subtrees that
+     * happen to write the same bytes from different classes, such as Div and
+     * Element<tags::div>, hash differently. Hashes are cached per
+     * node and invalidated by the same changes that invalidate GetCached(), so
+     * after a change only the path to the root is hashed again. Like the
+     * output cache, a node with a child shared with another parent is hashed
+     * every time. Frozen subtrees are hashed once, by Freeze().
+     */
+    std::uint64_t   Hash()
+    {
+        if (hash_valid)
+        {
+            return hash;
+        }
+
+        class   Frame
+        {
+        public:
+            NodeBase    *node;
+            std::size_t next;
+            bool        cacheable;
+        };
+
+        std::vector<Frame>  stack{{this, 0, true}};
+
+        while (!stack.empty())
+        {
+            Frame   &frame = stack.back();
+
+            if (frame.next < frame.node->children.size())
+            {
+                NodeBase    &child = *frame.node->children[frame.next++];
+
+                if (!child.frozen && child.parent != frame.node)
+                {
+                    frame.cacheable = false;
+                }
+                if (!child.hash_valid)
+                {
+                    stack.push_back({&child, 0, true});
+                }
+                continue;
+            }
+
+            // hash is written even when it cannot be kept, so the parent can read it.
+            NodeBase        &node = *frame.node;
+            std::uint64_t   h = node.NodeHash();
+            bool            cacheable = frame.cacheable;
+
+            for (auto &c : node.children)
+            {
+                h = HashMix(h ^ c->hash);
+                cacheable = cacheable && c->hash_valid;
+            }
+            node.hash = h;
+            node.hash_valid = cacheable;
+            stack.pop_back();
+        }
+
+        return hash;
+    }
+
+    /**
+     * @brief ETag returns a quoted entity tag for the output of Get(layout), without serializing.
+     *
+     * Built from Hash() and the layout, so it is as cheap as Hash() once the
+     * hashes are cached, and equal for equal trees across runs of the same
+     * build. Like Hash() it tells node classes apart: the same output built
+     * from other classes gets another tag, which costs a needless download
+     * but is never wrong. Suitable for If-None-Match checks.
+     */
+    std::string ETag(const Layout &layout = Layout())
+    {
+        static const char   hex[] = "0123456789abcdef";
+        std::uint64_t       h = HashMix(Hash() ^ HashMix((std::uint64_t(std::uint8_t(layout.indent_char)) << 33) ^
+                                                         (std::uint64_t(std::uint32_t(layout.indent_width)) << 1) ^
+                                                         std::uint64_t(layout.newlines)));
+        std::string         result(18, '"');
+
+        for (std::size_t i = 16; i > 0; --i, h >>= 4)
+        {
+            result[i] = hex[h & 0xf];
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Freeze makes the node and everything below it immutable.
+     *
+     * Mutating a frozen node throws std::logic_error. Frozen subtrees can be
+     * appended to any number of parents and written from many threads at once
+     * without locking; the output for indentation levels below 16 is rendered
+     * once and reused. Nodes reachable from this one through other parents
+     * are frozen too. Freeze before sharing the subtree with other threads.
+     */
+    void    Freeze()
+    {
+        std::vector<NodeBase*>  pending{this};
+
+        while (!pending.empty())
+        {
+            NodeBase    *node = pending.back();
+            pending.pop_back();
+
+            if (!node->frozen)
+            {
+                // A frozen node outlives any one parent it is shared by, so it keeps none.
+                node->frozen = true;
+                node->parent = nullptr;
+                std::string().swap(node->cache);
+                node->cache_owner = nullptr;
+
+                for (auto &c : node->children)
+                {
+                    pending.push_back(c.get());
+                }
+            }
+        }
+
+        // Hashed now, while no other thread can see the nodes yet.
+        Hash();
+    }
+
+    bool    is_frozen() {return frozen;}
+
+protected:
+    /**
+     * Writes the subtree through the node caches, refreshing the caches of changed nodes.
+     *
+     * Unchanged nodes are copied from the previous output of this node, at the
+     * position found by adding up the offsets recorded on the way down. The
+     * caller stores the new output in cache if cache_owner is this node.
+     */
+    void    WriteCached(StringSink &sink, int indentation)
+    {
+        static const std::size_t    unknown = std::string::npos;
+
+        class   CachedWriter
+        {
+        public:
+            class   State
+            {
+            public:
+                NodeBase    *node;
+                std::size_t start;
+                std::size_t previous;   ///< Start of the node in previous, or unknown.
+                bool        cacheable;
+                bool        repeated;   ///< Not the first occurrence under its parent in this pass.
+            };
+
+            StringSink          &sink;
+            const std::string   &previous;
+            std::vector<State>  states;
+            bool                repeated{false};    // set by Separator() for the node entered next
+
+            Visit   Enter(NodeBase &node, int indentation)
+            {
+                bool    repeat = repeated;
+                repeated = false;
+
+                if (node.frozen)
+                {
+                    // Frozen nodes are shared read-only, so their dirty caches are left alone.
+                    if (const std::string *output = node.FrozenOutput(sink.GetLayout(), indentation))
+                    {
+                        sink.Write(*output);
+                    }
+                    else
+                    {
+                        node.WriteNodes(sink, indentation, false);
+                    }
+                    return SkipNode;
+                }
+
+                std::size_t position = unknown;
+
+                // A repeated node's cache was already updated for its first occurrence in this pass.
+                if (states.empty())
+                {
+                    position = node.cache_owner == &node && node.cache_size == previous.size() ? 0 : unknown;
+                }
+                else if (!repeat && states.back().previous != unknown && node.cache_owner == states.back().node)
+                {
+                    position = states.back().previous + node.cache_offset;
+                }
+
+                if (position != unknown && !node.dirty && node.cache_indentation == indentation && node.cache_layout == sink.GetLayout())
+                {
+                    std::size_t start = sink.Size();
+
+                    sink.Write(previous.data() + position, node.cache_size);
+                    node.cache_offset = states.empty() ? 0 : start - states.back().start;
+                    node.cache_entered = !states.empty();
+                    return SkipNode;
+                }
+
+                // Cleared again when the parent is left.
+                node.cache_entered = !states.empty();
+                states.push_back({&node, sink.Size(), position, true, repeat});
+                node.WriteOpen(sink, indentation);
+
+                return VisitChildren;
+            }
+
+            void    Separator(NodeBase &parent, NodeBase &child)
+            {
+                parent.WriteSeparator(sink, child);
+
+                if (!child.frozen && (child.parent != &parent || child.cache_entered))
+                {
+                    states.back().cacheable = false;
+                }
+                repeated = !child.frozen && child.cache_entered;
+            }
+
+            void    Leave(NodeBase &node, int indentation)
+            {
+                node.WriteClose(sink, indentation);
+
+                State   state = states.back();
+                states.pop_back();
+
+                node.dirty = false;
+                for (auto &c : node.children)
+                {
+                    if (!c->frozen)
+                    {
+                        c->cache_entered = false;
+                    }
+                }
+
+                // Output kept from an earlier GetCached() on this node is superseded.
+                std::string().swap(node.cache);
+                if (state.repeated)
+                {
+                    // The cache keeps describing the first occurrence; the parent is not cached.
+                }
+                else if (state.cacheable && node._renders_children && !node.children.empty())
+                {
+                    node.cache_owner = states.empty() ? &node : states.back().node;
+                    node.cache_offset = states.empty() ? 0 : state.start - states.back().start;
+                    node.cache_size = sink.Size() - state.start;
+                    node.cache_indentation = indentation;
+                    node.cache_layout = sink.GetLayout();
+                }
+                else
+                {
+                    node.cache_owner = nullptr;
+                }
+
+                if (!state.cacheable && !states.empty())
+                {
+                    states.back().cacheable = false;
+                }
+            }
+        };
+
+        // The previous output is moved out, so it can be read while the new one is written.
+        std::string     previous;
+        previous.swap(cache);
+
+        CachedWriter    writer{sink, previous, {}};
+        Traverse(writer, indentation);
+    }
+
+public:
+    /**
+     * @brief SerializedSize returns the exact number of bytes Get(indentation) produces.
+     */
+    std::size_t SerializedSize(int indentation = 0)
+    {
+        return SerializedSize(Layout(), indentation);
+    }
+
+    std::size_t SerializedSize(const Layout &layout, int indentation = 0)
+    {
+        class   Counter
+        {
+        public:
+            const Layout    &layout;
+            std::size_t     size;
+
+            Visit   Enter(NodeBase &node, int indentation)
+            {
+                if (node.frozen)
+                {
+                    if (const std::string *output = node.FrozenOutput(layout, indentation))
+                    {
+                        size += output->size();
+                        return SkipNode;
+                    }
+                }
+
+                size += node.OpenSize(layout, indentation);
+                return VisitChildren;
+            }
+
+            void    Separator(NodeBase &parent, NodeBase &child)
+            {
+                size += parent.SeparatorSize(layout, child);
+            }
+
+            void    Leave(NodeBase &node, int indentation)
+            {
+                size += node.CloseSize(layout, indentation);
+            }
+        };
+
+        Counter counter{layout, 0};
+        Traverse(counter, indentation);
+
+        return counter.size;
+    }
+
+    /**
+     * @brief Render serializes the node into buffer and returns the number of bytes written.
+     *
+     * Throws std::length_error if capacity is less than SerializedSize(layout, indentation).
+     */
+    std::size_t Render(char *buffer, std::size_t capacity, int indentation = 0, const Layout &layout = Layout())
+    {
+        BufferSink  sink(buffer, capacity);
+
+        sink.SetLayout(layout);
+        Write(sink, indentation);
+
+        return sink.Size();
+    }
+
+    /**
+     * @brief GetPresized returns the same as Get(), but allocates the result exactly once.
+     */
+    std::string GetPresized(int indentation = 0, const Layout &layout = Layout())
+    {
+        std::string result(SerializedSize(layout, indentation), '\0');
+
+        Render(&result[0], result.size(), indentation, layout);
+
+        return result;
+    }
+
+    bool    is_inline() {return _is_inline;}
+
+    const TagName&  Tag() const {return *tag;}
+
+    friend  std::ostream& operator<<(std::ostream &stream, NodeBase &node);
+    friend  class   StreamWriter;
+    friend  class   Template;
+    friend  class   HtmlParser;
+    friend  class   Patch;
+    friend  class   NodeInterner;
+};
+
+inline  std::ostream& operator<<(std::ostream &stream, NodeBase &node)
+{
+    StreamSink  sink(stream);
+
+    node.Write(sink);
+    sink.Flush();
+
+    return stream;
+}
+
+inline  std::shared_ptr<NodeBase>   GetNodeBase(std::string name)
+{
+    return Get<NodeBase>(std::move(name));
+}
+
+inline  std::shared_ptr<NodeBase>   GetNodeBase(std::string name, std::string value)
+{
+    return Get<NodeBase>(std::move(name), std::move(value));
+}
+
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Void class handles a void node (node without end tag) like <br> or <img>.
+ */
+class   Void : public NodeBase
+{
+    Sink&   EndTag(Sink &sink) override
+    {
+        return sink;
+    }
+
+    std::size_t EndTagSize() override
+    {
+        return 0;
+    }
+protected:
+    void    WriteOpen(Sink &sink, int indentation) override
+    {
+        WriteIdentation(sink, indentation);
+        StartTag(sink);
+    }
+
+    void    WriteClose(Sink &sink, int /*indentation*/) override
+    {
+        EndTag(sink);
+    }
+
+    std::size_t OpenSize(const Layout &layout, int indentation) override
+    {
+        return IdentationSize(layout, indentation) + StartTagSize();
+    }
+
+    std::size_t CloseSize(const Layout &/*layout*/, int /*indentation*/) override
+    {
+        return EndTagSize();
+    }
+public:
+    Void(const TagName &tag)
+        : NodeBase(tag)
+    {
+        _renders_children = false;
+#ifdef __DEBUG
+        std::cout << "Constructing Void" << std::endl;
+#endif
+    }
+    Void(std::string name)
+        : Void(InternTagName(name))
+    {
+    }
+    virtual ~Void()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Void" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<Void>   GetVoid(std::string name)
+{
+    return Get<Void>(std::move(name));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The NodeLine class handles a one-line node.
+ */
+class   NodeLine : public NodeBase
+{
+protected:
+    void    WriteOpen(Sink &sink, int indentation) override
+    {
+        WriteIdentation(sink, indentation);
+        StartTag(sink);
+
+        if (value.length() > 0)
+        {
+            WriteEscaped<false>(sink, value);
+        }
+    }
+
+    void    WriteClose(Sink &sink, int /*indentation*/) override
+    {
+        EndTag(sink);
+    }
+
+    std::size_t OpenSize(const Layout &layout, int indentation) override
+    {
+        return IdentationSize(layout, indentation) + StartTagSize() + EscapedSize<false>(value);
+    }
+
+    std::size_t CloseSize(const Layout &/*layout*/, int /*indentation*/) override
+    {
+        return EndTagSize();
+    }
+public:
+    NodeLine(const TagName &tag)
+        : NodeBase(tag)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing NodeLine" << std::endl;
+#endif
+    }
+    NodeLine(const TagName &tag, std::string value)
+        : NodeBase(tag, std::move(value))
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing NodeLine" << std::endl;
+#endif
+    }
+    NodeLine(std::string name)
+        : NodeLine(InternTagName(name))
+    {
+    }
+    NodeLine(std::string name, std::string value)
+        : NodeLine(InternTagName(name), std::move(value))
+    {
+    }
+    virtual ~NodeLine()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing NodeLine" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<NodeLine>   GetNodeLine(std::string name)
+{
+    return Get<NodeLine>(std::move(name));
+}
+
+inline  std::shared_ptr<NodeLine>   GetNodeLine(std::string name, std::string value)
+{
+    return Get<NodeLine>(std::move(name), std::move(value));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The NodeInline class handles a one-line node inserted inline.
+ */
+class   NodeInline : public NodeLine
+{
+protected:
+    void    WriteSeparator(Sink &/*sink*/, NodeBase &/*child*/) override
+    {
+    }
+
+    std::size_t SeparatorSize(const Layout &/*layout*/, NodeBase &/*child*/) override
+    {
+        return 0;
+    }
+public:
+    NodeInline(const TagName &tag)
+        : NodeLine(tag)
+    {
+        _is_inline = true;
+#ifdef __DEBUG
+        std::cout << "Constructing NodeInline" << std::endl;
+#endif
+    }
+    NodeInline(const TagName &tag, std::string value)
+        : NodeLine(tag, std::move(value))
+    {
+        _is_inline = true;
+#ifdef __DEBUG
+        std::cout << "Constructing NodeInline" << std::endl;
+#endif
+    }
+    NodeInline(std::string name)
+        : NodeInline(InternTagName(name))
+    {
+    }
+    NodeInline(std::string name, std::string value)
+        : NodeInline(InternTagName(name), std::move(value))
+    {
+    }
+    virtual ~NodeInline()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing NodeInline" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<NodeInline>   GetNodeInline(std::string name)
+{
+    return Get<NodeInline>(std::move(name));
+}
+
+inline  std::shared_ptr<NodeInline>   GetNodeInline(std::string name, std::string value)
+{
+    return Get<NodeInline>(std::move(name), std::move(value));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Element class template is an element with a compile-time tag, e.g. Element<tags::td, NodeLine>.
+ *
+ * Kind selects the layout: NodeBase (block), NodeLine, NodeInline or Void.
+ */
+template<const TagName &tag, typename Kind = NodeBase>
+class   Element : public Kind
+{
+public:
+    Element()
+        : Kind(tag)
+    {
+    }
+
+    Element(std::string value)
+        : Kind(tag, std::move(value))
+    {
+    }
+};
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+/**
+ * @brief The Document class handles a document node, <html></html>.
+ */
+class   Document : public NodeBase
+{
+    std::shared_ptr<Arena>  arena{std::make_shared<Arena>()};
+    NodeIndex               node_index;
+protected:
+    void    WriteOpen(Sink &sink, int indentation) override
+    {
+        sink.Write("<!DOCTYPE html>", 15);
+        sink.Newline();
+        NodeBase::WriteOpen(sink, indentation);
+    }
+
+    std::size_t OpenSize(const Layout &layout, int indentation) override
+    {
+        return 15 + layout.NewlineSize() + NodeBase::OpenSize(layout, indentation);
+    }
+public:
+    Document()
+        : NodeBase(tags::html)
+    {
+        index = &node_index;
+#ifdef __DEBUG
+        std::cout << "Constructing Document" << std::endl;
+#endif
+    }
+
+    virtual ~Document()
+    {
+        // Nodes that outlive the document must not refer to its index.
+        DetachFromIndex(node_index);
+#ifdef __DEBUG
+        std::cout << "Destructing Document" << std::endl;
+#endif
+    }
+
+    /// The arena owned by the document, see ArenaScope.
+    std::shared_ptr<Arena>  GetArena() {return arena;}
+
+    /**
+     * @brief FindById returns the node with the id attribute id, or nullptr.
+     *
+     * The index behind FindById() and FindByClass() is updated as nodes are
+     * appended below the document and as they get id and class attributes. A
+     * node shared with another document is only kept up to date in the one it
+     * was appended to first, and frozen subtrees are indexed as they were when
+     * appended.
+     */
+    NodeBase*   FindById(const std::string &id) const {return node_index.FindById(id);}
+
+    /// The nodes that have class_name among their classes, in the order they were added.
+    const std::vector<NodeBase*>&   FindByClass(const std::string &class_name) const {return node_index.FindByClass(class_name);}
+
+    /// Ids given to more than one node, e.g. a node appended twice; FindById() returns the first.
+    const std::vector<std::string>& DuplicateIds() const {return node_index.DuplicateIds();}
+
+#ifdef SIMPLE_HTML_HAS_POSIX
+    /**
+     * @brief WriteToFile serializes the document straight into the file at path.
+     *
+     * Unlike `file << doc` no copy of the whole output is kept in memory.
+     * Returns the number of bytes written; throws std::system_error on failure.
+     */
+    std::size_t WriteToFile(const std::string &path, const FileOptions &options = FileOptions())
+    {
+        if (options.method == FileOptions::Buffered)
+        {
+            FileSink    sink(path, options);
+
+            Write(sink);
+
+            return sink.Close();
+        }
+
+        auto    fail = [](const char *operation)
+        {
+            throw std::system_error(errno, std::generic_category(), std::string("simple_html::Document::WriteToFile: ") + operation);
+        };
+
+        std::size_t size = SerializedSize(options.layout);
+        int         fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+        if (fd == -1)
+        {
+            fail("open");
+        }
+
+        std::unique_ptr<int, void(*)(int*)> closer(&fd, [](int *f) {if (*f != -1) ::close(*f);});
+
+        if (::ftruncate(fd, off_t(size)) == -1)
+        {
+            fail("ftruncate");
+        }
+
+        void    *view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED)
+        {
+            fail("mmap");
+        }
+        ::madvise(view, size, MADV_SEQUENTIAL);
+
+        try
+        {
+            Render(static_cast<char*>(view), size, 0, options.layout);
+        }
+        catch (...)
+        {
+            ::munmap(view, size);
+            throw;
+        }
+
+        if (options.sync != FileOptions::NoSync && ::msync(view, size, MS_SYNC) == -1)
+        {
+            ::munmap(view, size);
+            fail("msync");
+        }
+        ::munmap(view, size);
+
+        if ((options.sync == FileOptions::DataSync && ::fdatasync(fd) == -1) ||
+            (options.sync == FileOptions::FullSync && ::fsync(fd) == -1))
+        {
+            fail("sync");
+        }
+
+        int result = ::close(fd);
+        fd = -1;
+        if (result == -1)
+        {
+            fail("close");
+        }
+
+        return size;
+    }
+#endif
+};
+
+inline  std::ostream& operator<<(std::ostream &stream, Document &node)
+{
+    return stream << static_cast<NodeBase&>(node);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The ArenaScope class routes node allocations on this thread to an arena while in scope.
+ *
+ * Nodes created through Get<T>() and the GetXxx() helpers are placed in the
+ * arena:
+ *
+ *      Document    doc;
+ *      ArenaScope  scope(doc);
+ *      auto        body = doc.AppendChild(Get<Body>());
+ */
+class   ArenaScope
+{
+    std::shared_ptr<Arena>  previous;
+public:
+    ArenaScope(std::shared_ptr<Arena> arena)
+        : previous(std::move(CurrentArena()))
+    {
+        CurrentArena() = std::move(arena);
+    }
+
+    ArenaScope(Document &document)
+        : ArenaScope(document.GetArena())
+    {
+    }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope& operator=(const ArenaScope &) = delete;
+
+    ~ArenaScope()
+    {
+        CurrentArena() = std::move(previous);
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The StreamWriter class writes a document forward-only, without building the whole tree.
+ *
+ * Open() writes the start tag of a node (and anything already appended to it)
+ * and makes it the current parent; Append() serializes a complete subtree
+ * into the current parent, after which the caller may drop it; Close() writes
+ * the end tag. Output is identical to building the tree and calling Write(),
+ * while memory stays proportional to the nesting depth:
+ *
+ *      FileSink        sink("export.html");
+ *      StreamWriter    writer(sink);
+ *      {
+ *          auto    document = writer.Open(Get<Document>());
+ *          auto    body = writer.Open(Get<Body>());
+ *          auto    table = writer.Open(Get<Table>("Export"));
+ *
+ *          for (auto &record : records)
+ *          {
+ *              auto    row = Get<TableRow>();
+ *              ...
+ *              writer.Append(row);
+ *          }
+ *      }
+ *      sink.Close();
+ *
+ * Nodes are freed as soon as they are released, so do not create them inside
+ * an ArenaScope; the arena only releases memory when it is destroyed.
+ */
+class   StreamWriter
+{
+    class   Frame
+    {
+    public:
+        std::shared_ptr<NodeBase>   node;
+        int                         indentation;
+    };
+
+    Sink                &sink;
+    std::vector<Frame>  open;
+    int                 indentation;
+
+public:
+    /**
+     * @brief The Element class closes an opened node when it goes out of scope.
+     */
+    class   Element
+    {
+        StreamWriter    *writer;
+        std::size_t     depth;
+        int             exceptions{std::uncaught_exceptions()};
+    public:
+        Element(StreamWriter &writer, std::size_t depth)
+            : writer(&writer),
+              depth(depth)
+        {
+        }
+
+        Element(Element &&other)
+            : writer(other.writer),
+              depth(other.depth),
+              exceptions(other.exceptions)
+        {
+            other.writer = nullptr;
+        }
+
+        Element(const Element &) = delete;
+        Element& operator=(const Element &) = delete;
+
+        /// Does not write the end tag while an exception unwinds the scope.
+        ~Element() noexcept(false)
+        {
+            if (writer != nullptr && std::uncaught_exceptions() == exceptions)
+            {
+                Close();
+            }
+        }
+
+        /// Closes the node, and any node opened inside it that is still open.
+        void    Close()
+        {
+            if (writer != nullptr)
+            {
+                while (writer->Depth() >= depth)
+                {
+                    writer->Close();
+                }
+                writer = nullptr;
+            }
+        }
+    };
+
+    StreamWriter(Sink &sink, int indentation = 0)
+        : sink(sink),
+          indentation(indentation)
+    {
+    }
+
+    StreamWriter(const StreamWriter &) = delete;
+    StreamWriter& operator=(const StreamWriter &) = delete;
+
+    /**
+     * @brief Open writes the start of node and makes it the parent of the following nodes.
+     *
+     * Throws std::logic_error for nodes that cannot have children, like Text or Image.
+     */
+    Element Open(std::shared_ptr<NodeBase> node)
+    {
+        if (!node->_renders_children)
+        {
+            throw std::logic_error("simple_html::StreamWriter: node cannot have children");
+        }
+
+        int node_indentation = open.empty() ? indentation : open.back().indentation + 1;
+
+        if (!open.empty())
+        {
+            open.back().node->WriteSeparator(sink, *node);
+        }
+
+        node->WriteOpen(sink, node_indentation);
+        for (auto &c : node->children)
+        {
+            node->WriteSeparator(sink, *c);
+            c->Write(sink, node_indentation + 1);
+        }
+
+        open.push_back({std::move(node), node_indentation});
+
+        return Element(*this, open.size());
+    }
+
+    /**
+     * @brief Append writes node and its children as the next child of the current parent.
+     */
+    void    Append(const std::shared_ptr<NodeBase> &node)
+    {
+        if (open.empty())
+        {
+            node->Write(sink, indentation);
+            return;
+        }
+
+        open.back().node->WriteSeparator(sink, *node);
+        node->Write(sink, open.back().indentation + 1);
+    }
+
+    /**
+     * @brief Close writes the end of the most recently opened node and releases it.
+     */
+    void    Close()
+    {
+        if (open.empty())
+        {
+            throw std::logic_error("simple_html::StreamWriter: no open node");
+        }
+
+        Frame   frame = std::move(open.back());
+        open.pop_back();
+
+        frame.node->WriteClose(sink, frame.indentation);
+    }
+
+    /// Number of nodes currently open.
+    std::size_t Depth() const {return open.size();}
+};
+
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Slot class marks a place in a tree that a Template fills in per rendering.
+ *
+ * A NodeSlot takes the place of a child node and is filled with a subtree or
+ * text; a TextSlot is an inline text placeholder. The parent's newline in
+ * front of a NodeSlot is only written when the slot is filled with a block
+ * node, so a rendered template matches the tree built with the fill in place
+ * of the slot. Outside a template a slot writes nothing itself, though the
+ * parent still writes its newline in front of a NodeSlot.
+ */
+class   Slot : public NodeBase
+{
+    std::string     slot_name;
+    Sink::SlotKind  kind;
+protected:
+    void    WriteOpen(Sink &sink, int indentation) override
+    {
+        // What the parent this slot is written under wrote in front of it, as it would for a block child.
+        sink.WriteSlot(kind, slot_name, indentation, sink.LastSeparator());
+    }
+
+    std::uint64_t   HashContent() override
+    {
+        return HashBytes(kind, slot_name);
+    }
+
+    void    WriteClose(Sink &/*sink*/, int /*indentation*/) override
+    {
+    }
+
+    std::size_t OpenSize(const Layout &/*layout*/, int /*indentation*/) override
+    {
+        return 0;
+    }
+
+    std::size_t CloseSize(const Layout &/*layout*/, int /*indentation*/) override
+    {
+        return 0;
+    }
+public:
+    Slot(std::string name, Sink::SlotKind kind = Sink::NodeSlot)
+        : NodeBase(tags::text),
+          slot_name(std::move(name)),
+          kind(kind)
+    {
+        _is_inline = kind != Sink::NodeSlot;
+        _renders_children = false;
+#ifdef __DEBUG
+        std::cout << "Constructing Slot" << std::endl;
+#endif
+    }
+
+    virtual ~Slot()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Slot" << std::endl;
+#endif
+    }
+
+    const std::string&  Name() const {return slot_name;}
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The TemplateValues class holds what goes into the slots of a Template for one rendering.
+ */
+class   TemplateValues
+{
+    std::unordered_map<std::string, std::string>                text;
+    std::unordered_map<std::string, std::shared_ptr<NodeBase>>  nodes;
+
+    friend  class   Template;
+public:
+    /// Text for a slot of any kind; it is escaped when written.
+    TemplateValues& Set(const std::string &slot, std::string value)
+    {
+        text[slot] = std::move(value);
+        return *this;
+    }
+
+    /// A subtree for a NodeSlot.
+    TemplateValues& Set(const std::string &slot, std::shared_ptr<NodeBase> node)
+    {
+        nodes[slot] = std::move(node);
+        return *this;
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Template class is a subtree compiled to static bytes and named slots.
+ *
+ * The subtree is serialized once; rendering only copies the static bytes and
+ * writes the slot values in between:
+ *
+ *      auto    body = doc.AppendChild(Get<Body>());
+ *      body->AppendChild(Get<Heading>("Report", 1))->AppendAttributeSlot("id", "anchor");
+ *      body->AppendChild(Get<Slot>("content"));
+ *
+ *      const Template  page(doc);
+ *      std::string     html = page.Render(TemplateValues().Set("anchor", "top").Set("content", table));
+ *
+ * Later changes to the subtree do not affect the template. Render() is const
+ * and may be called from many threads at once, provided the node values are
+ * not modified meanwhile. Slots without a value render as nothing.
+ */
+class   Template
+{
+    class   Part
+    {
+    public:
+        std::size_t     offset;
+        std::size_t     separator;  ///< Bytes before offset only written for a block node.
+        Sink::SlotKind  kind;
+        std::string     name;
+        int             indentation;
+    };
+
+    class   CompileSink : public StringSink
+    {
+        std::vector<Part>   &parts;
+    public:
+        CompileSink(std::string &target, std::vector<Part> &parts)
+            : StringSink(target),
+              parts(parts)
+        {
+        }
+
+        void    WriteSlot(SlotKind kind, const std::string &name, int indentation, std::size_t separator) override
+        {
+            parts.push_back({Size(), separator, kind, name, indentation});
+        }
+    };
+
+    std::string         bytes;
+    std::vector<Part>   parts;
+    Layout              layout;
+
+public:
+    Template(NodeBase &root, int indentation = 0, const Layout &layout = Layout())
+        : layout(layout)
+    {
+        CompileSink sink(bytes, parts);
+
+        sink.SetLayout(layout);
+        // Frozen caches have no slot positions, so everything is written afresh.
+        root.WriteNodes(sink, indentation, false);
+        sink.Flush();
+    }
+
+    /// Writes the template into sink; subtrees in slots use the template's layout.
+    void    Render(Sink &sink, const TemplateValues &values) const
+    {
+        Layout      previous = sink.GetLayout();
+        std::size_t offset = 0;
+
+        sink.SetLayout(layout);
+
+        for (auto &p : parts)
+        {
+            sink.Write(bytes.data() + offset, p.offset - p.separator - offset);
+            offset = p.offset;
+
+            if (p.kind == Sink::NodeSlot)
+            {
+                auto    node = values.nodes.find(p.name);
+                if (node != values.nodes.end())
+                {
+                    if (!node->second->is_inline())
+                    {
+                        sink.Write(bytes.data() + p.offset - p.separator, p.separator);
+                    }
+                    node->second->Write(sink, p.indentation);
+                    continue;
+                }
+            }
+
+            auto    text = values.text.find(p.name);
+            if (text != values.text.end())
+            {
+                if (p.kind == Sink::AttributeSlot)
+                {
+                    WriteEscaped<true>(sink, text->second);
+                }
+                else
+                {
+                    WriteEscaped<false>(sink, text->second);
+                }
+            }
+        }
+
+        sink.Write(bytes.data() + offset, bytes.size() - offset);
+        sink.SetLayout(previous);
+    }
+
+    std::string Render(const TemplateValues &values) const
+    {
+        std::string result;
+        StringSink  sink(result);
+
+        Render(sink, values);
+        sink.Flush();
+
+        return result;
+    }
+
+    /// Number of slots, counting every occurrence.
+    std::size_t SlotCount() const {return parts.size();}
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Head class handles a head node, <head></head>.
+ */
+class   Head : public NodeBase
+{
+public:
+    Head()
+        : NodeBase(tags::head)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing Head" << std::endl;
+#endif
+    }
+
+    virtual ~Head()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Head" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<Head>   GetHead()
+{
+    return Get<Head>();
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Body class handles a body node, <body></body>.
+ */
+class   Body : public NodeBase
+{
+public:
+    Body()
+        : NodeBase(tags::body)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing Body" << std::endl;
+#endif
+    }
+
+    virtual ~Body()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Body" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<Body>   GetNodeInline()
+{
+    return Get<Body>();
+}
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+/**
+ * @brief The ResourceLink class handles a resource link, <link rel="relation">.
+ */
+class   ResourceLink : public Void
+{
+public:
+    ResourceLink(std::string relation)
+        : Void(tags::link)
+    {
+        this->AppendAttribute("rel", std::move(relation));
+#ifdef __DEBUG
+        std::cout << "Constructing ResourceLink" << std::endl;
+#endif
+    }
+
+    virtual ~ResourceLink()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing ResourceLink" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<ResourceLink>   GetResourceLink(std::string relation)
+{
+    return Get<ResourceLink>(std::move(relation));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The CSSResourceLink class handles a css resource link, <link rel="relation", href="url", type="text/css">.
+ */
+class   CSSResourceLink : public ResourceLink
+{
+public:
+    CSSResourceLink(std::string relation, std::string url)
+        : ResourceLink(std::move(relation))
+    {
+        this->AppendAttribute("href", std::move(url));
+        this->AppendAttribute("type", "text/css");
+#ifdef __DEBUG
+        std::cout << "Constructing ResourceLink" << std::endl;
+#endif
+    }
+
+    virtual ~CSSResourceLink()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing ResourceLink" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Link class handles a one-line link tag <a href="url">text</a>.
+ */
+class   Link : public NodeInline
+{
+public:
+    Link()
+        : NodeInline(tags::a)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing Link" << std::endl;
+#endif
+    }
+
+    Link(std::string url, std::string text)
+        : NodeInline(tags::a, std::move(text))
+    {
+        this->AppendAttribute("href", std::move(url));
+#ifdef __DEBUG
+        std::cout << "Constructing Link" << std::endl;
+#endif
+    }
+
+    virtual ~Link()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Link" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<Link>   GetLink(std::string url, std::string text)
+{
+    return Get<Link>(std::move(url), std::move(text));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Image class handles an image tag, <img ...>.
+ */
+class   Image : public Void
+{
+public:
+    Image()
+        : Void(tags::img)
+    {
+        _is_inline = true;
+#ifdef __DEBUG
+        std::cout << "Constructing Image" << std::endl;
+#endif
+    }
+
+    //<img src="pic_mountain.jpg" alt="Mountain View" style="width:304px;height:228px;">
+    Image(std::string url, std::string alt_text, int width, int height, bool old_style = false)
+        : Void(tags::img)
+    {
+        _is_inline = true;
+#ifdef __DEBUG
+        std::cout << "Constructing Image" << std::endl;
+#endif
+
+        this->AppendAttribute("src", std::move(url));
+        this->AppendAttribute("alt", std::move(alt_text));
+
+        if (!old_style)
+        {
+            char        number[number_buffer_size];
+            std::string style;
+
+            style.reserve(32);
+            style.append("width:").append(number, FormatNumber(number, width));
+            style.append("px;height:").append(number, FormatNumber(number, height)).append("px");
+            this->AppendAttribute("style", std::move(style));
+        }
+        else
+        {
+            this->AppendAttribute("width", width);
+            this->AppendAttribute("height", height);
+        }
+    }
+
+    virtual ~Image()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Image" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Break class handles a break tag, <br>.
+ */
+class   Break : public Void
+{
+public:
+    Break()
+        : Void(tags::br)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing Break" << std::endl;
+#endif
+    }
+    virtual ~Break()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Break" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<Break>   GetBreak()
+{
+    return Get<Break>();
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Title class handles a one-line title node, <title></title>.
+ */
+class   Title : public NodeLine
+{
+public:
+    Title(std::string text)
+        : NodeLine(tags::title, std::move(text))
+    {
+#ifdef __DEBUG
+       std:: cout << "Constructing Title" << std::endl;
+#endif
+    }
+
+    virtual ~Title()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Title" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<Title>   GetTitle(std::string text)
+{
+    return Get<Title>(std::move(text));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Heading class handles a one-line heading node, <h[level]></h[level]>.
+ */
+class   Heading : public NodeLine
+{
+public:
+    Heading(std::string text, int level)
+        : NodeLine(tags::h1, std::move(text))
+    {
+        static const TagName    *levels[] = {&tags::h1, &tags::h2, &tags::h3, &tags::h4, &tags::h5, &tags::h6};
+
+        tag = (level >= 1 && level <= 6) ? levels[level - 1] : &InternTagName("h" + std::to_string(level));
+
+#ifdef __DEBUG
+       std:: cout << "Constructing Heading" << std::endl;
+#endif
+    }
+
+    virtual ~Heading()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Heading" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<Heading>   GetHeading(std::string text, int level)
+{
+    return Get<Heading>(std::move(text), level);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Text class handles a one-line node without tags representing text.
+ */
+class   Text : public NodeInline
+{
+protected:
+    void    WriteOpen(Sink &sink, int indentation) override
+    {
+        WriteIdentation(sink, indentation);
+        WriteEscaped<false>(sink, value);
+    }
+
+    void    WriteClose(Sink &/*sink*/, int /*indentation*/) override
+    {
+    }
+
+    std::size_t OpenSize(const Layout &layout, int indentation) override
+    {
+        return IdentationSize(layout, indentation) + EscapedSize<false>(value);
+    }
+
+    std::size_t CloseSize(const Layout &/*layout*/, int /*indentation*/) override
+    {
+        return 0;
+    }
+public:
+    Text(std::string text)
+        : NodeInline(tags::text, std::move(text))
+    {
+        _renders_children = false;
+#ifdef __DEBUG
+        std::cout << "Constructing Text" << std::endl;
+#endif
+    }
+
+    virtual ~Text()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Text" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<Text>   GetText(std::string text)
+{
+    return Get<Text>(std::move(text));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The RawText class handles trusted, already escaped text that is written verbatim.
+ */
+class   RawText : public Text
+{
+protected:
+    void    WriteOpen(Sink &sink, int indentation) override
+    {
+        WriteIdentation(sink, indentation);
+        sink.Write(value);
+    }
+
+    std::size_t OpenSize(const Layout &layout, int indentation) override
+    {
+        return IdentationSize(layout, indentation) + value.size();
+    }
+public:
+    RawText(std::string html)
+        : Text(std::move(html))
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing RawText" << std::endl;
+#endif
+    }
+
+    virtual ~RawText()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing RawText" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<RawText>   GetRawText(std::string html)
+{
+    return Get<RawText>(std::move(html));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Span class handles a one-line Span node, <span></span>.
+ */
+class   Span : public NodeInline
+{
+public:
+    Span()
+        : NodeInline(tags::span)
+    {
+#ifdef __DEBUG
+       std:: cout << "Constructing Span" << std::endl;
+#endif
+    }
+
+    Span(std::string text)
+        : NodeInline(tags::span, std::move(text))
+    {
+#ifdef __DEBUG
+       std:: cout << "Constructing Span" << std::endl;
+#endif
+    }
+
+    virtual ~Span()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Span" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Div class handles a one-line Div node, <div></div>.
+ */
+class   Div : public NodeBase
+{
+public:
+    Div()
+        : NodeBase(tags::div)
+    {
+#ifdef __DEBUG
+       std:: cout << "Constructing Div" << std::endl;
+#endif
+    }
+
+    virtual ~Div()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Div" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Sub class handles a one-line subscript node, <sub></sub>.
+ */
+class   SubScript : public NodeInline
+{
+public:
+    SubScript()
+        : NodeInline(tags::sub)
+    {
+#ifdef __DEBUG
+       std:: cout << "Constructing SubScript" << std::endl;
+#endif
+    }
+
+    SubScript(std::string text)
+        : NodeInline(tags::sub, std::move(text))
+    {
+#ifdef __DEBUG
+       std:: cout << "Constructing SubScript" << std::endl;
+#endif
+    }
+
+    virtual ~SubScript()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing SubScript" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<SubScript>   GetSubScript()
+{
+    return Get<SubScript>();
+}
+
+inline  std::shared_ptr<SubScript>   GetSubScript(std::string text)
+{
+    return Get<SubScript>(std::move(text));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Sup class handles a one-line superscript node, <sup></sup>.
+ */
+class   SuperScript : public NodeInline
+{
+public:
+    SuperScript()
+        : NodeInline(tags::sup)
+    {
+#ifdef __DEBUG
+       std:: cout << "Constructing SuperScript" << std::endl;
+#endif
+    }
+
+    SuperScript(std::string text)
+        : NodeInline(tags::sup, std::move(text))
+    {
+#ifdef __DEBUG
+       std:: cout << "Constructing SuperScript" << std::endl;
+#endif
+    }
+
+    virtual ~SuperScript()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing SuperScript" << std::endl;
+#endif
+    }
+};
+
+inline  std::shared_ptr<SuperScript>   GetSuperScript()
+{
+    return Get<SuperScript>();
+}
+
+inline  std::shared_ptr<SuperScript>   GetSuperScript(std::string text)
+{
+    return Get<SuperScript>(std::move(text));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Paragraph class handles a pragraph node, <p></p>.
+ */
+class   Paragraph : public NodeBase
+{
+public:
+    Paragraph()
+        : NodeBase(tags::p, "")
+    {
+#ifdef __DEBUG
+       std:: cout << "Constructing Paragraph" << std::endl;
+#endif
+    }
+
+    Paragraph(std::string text)
+        : NodeBase(tags::p, std::move(text))
+    {
+#ifdef __DEBUG
+       std:: cout << "Constructing Paragraph" << std::endl;
+#endif
+    }
+
+    virtual ~Paragraph()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Paragraph" << std::endl;
+#endif
+    }
+
+    std::shared_ptr<NodeBase>   AppendText(std::string text)
+    {
+        return AppendChild(simple_html::Get<Text>(std::move(text)));
+    }
+};
+
+inline  std::shared_ptr<Paragraph>   GetParagraph()
+{
+    return Get<Paragraph>();
+}
+
+inline  std::shared_ptr<Paragraph>   GetParagraph(std::string text)
+{
+    return Get<Paragraph>(std::move(text));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The ListItem class handles a one-line list item node, <li></li>.
+ */
+class   ListItem : public NodeBase
+{
+public:
+    ListItem()
+        : NodeBase(tags::li)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing ListItem" << std::endl;
+#endif
+    }
+
+    ListItem(std::string text)
+        : NodeBase(tags::li, std::move(text))
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing ListItem" << std::endl;
+#endif
+    }
+
+    virtual ~ListItem()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing ListItem" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The UnorderedList class handles an unordered list, <ul></ul>.
+ */
+class   UnorderedList : public NodeBase
+{
+public:
+    UnorderedList()
+        : NodeBase(tags::ul)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing UnorderedList" << std::endl;
+#endif
+    }
+
+    virtual ~UnorderedList()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing UnorderedList" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The OrderedList class handles an ordered list, <ol></ol>.
+ */
+class   OrderedList : public NodeBase
+{
+public:
+    OrderedList()
+        : NodeBase(tags::ol)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing OrderedList" << std::endl;
+#endif
+    }
+
+    virtual ~OrderedList()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing OrderedList" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Table class  handles an ordered list, <table></table>.
+ */
+class   Table : public NodeBase
+{
+public:
+    Table()
+        : NodeBase(tags::table)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing Table" << std::endl;
+#endif
+    }
+
+    Table(std::string caption)
+        : NodeBase(tags::table)
+    {
+        AppendChild(simple_html::Get<NodeBase>(tags::caption, std::move(caption)));
+#ifdef __DEBUG
+        std::cout << "Constructing Table" << std::endl;
+#endif
+    }
+
+    virtual ~Table()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing Table" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The TableRow class handles a table row, <tr></tr>.
+ */
+class   TableRow : public NodeBase
+{
+public:
+    TableRow()
+        : NodeBase(tags::tr)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing TableRow" << std::endl;
+#endif
+    }
+
+    virtual ~TableRow()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing TableRow" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The TableElement class handles a one-line table element node, i.e. cell, <td>text</td>.
+ */
+class   TableElement : public NodeLine
+{
+public:
+    TableElement()
+        : NodeLine(tags::td)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing TableElement" << std::endl;
+#endif
+    }
+
+    TableElement(std::string text)
+        : NodeLine(tags::td, std::move(text))
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing TableElement" << std::endl;
+#endif
+    }
+
+    virtual ~TableElement()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing TableElement" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The TableHeaderElement class handles a one line table header element node, <th>text</th>.
+ */
+class   TableHeaderElement : public NodeLine
+{
+public:
+    TableHeaderElement()
+        : NodeLine(tags::th)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing TableHeaderElement" << std::endl;
+#endif
+    }
+
+    TableHeaderElement(std::string text)
+        : NodeLine(tags::th, std::move(text))
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing TableHeaderElement" << std::endl;
+#endif
+    }
+
+    virtual ~TableHeaderElement()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing TableHeaderElement" << std::endl;
+#endif
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The TableColumn class holds one column of a ColumnTable: header, cell tags and values.
+ */
+class   TableColumn
+{
+public:
+    enum    Kind
+    {
+        Doubles,
+        Integers,
+        Strings
+    };
+
+private:
+    Kind                            kind;
+    std::string                     header;
+    std::string                     cell_open{"<td>"};
+    std::string                     header_open{"<th>"};
+    NumberFormat                    format;
+    std::vector<double>             doubles;
+    std::vector<std::int64_t>       integers;
+    std::vector<std::string_view>   strings;
+
+    void    SetClass(const std::string &class_name)
+    {
+        if (class_name.empty())
+        {
+            return;
+        }
+
+        std::string attribute;
+        {
+            StringSink  sink(attribute);
+            sink.Write(" class=\"", 8);
+            WriteEscaped<true>(sink, class_name);
+            sink.Write("\">", 2);
+        }
+
+        cell_open = "<td" + attribute;
+        header_open = "<th" + attribute;
+    }
+
+public:
+    TableColumn(std::string header, std::vector<double> values, NumberFormat format, const std::string &class_name)
+        : kind(Doubles),
+          header(std::move(header)),
+          format(format),
+          doubles(std::move(values))
+    {
+        SetClass(class_name);
+    }
+
+    TableColumn(std::string header, std::vector<std::int64_t> values, const std::string &class_name)
+        : kind(Integers),
+          header(std::move(header)),
+          integers(std::move(values))
+    {
+        SetClass(class_name);
+    }
+
+    TableColumn(std::string header, std::vector<std::string_view> values, const std::string &class_name)
+        : kind(Strings),
+          header(std::move(header)),
+          strings(std::move(values))
+    {
+        SetClass(class_name);
+    }
+
+    Kind                GetKind() const {return kind;}
+    const std::string&  Header() const {return header;}
+
+    std::size_t size() const
+    {
+        switch (kind)
+        {
+        case Doubles:   return doubles.size();
+        case Integers:  return integers.size();
+        default:        return strings.size();
+        }
+    }
+
+    /// Writes <th>header</th>.
+    void    WriteHeader(Sink &sink) const
+    {
+        sink.Write(header_open);
+        WriteEscaped<false>(sink, header);
+        sink.Write("</th>", 5);
+    }
+
+    std::size_t HeaderSize() const
+    {
+        return header_open.size() + EscapedSize<false>(header) + 5;
+    }
+
+    /// Writes <td>value</td> for the given row.
+    void    WriteCell(Sink &sink, std::size_t row) const
+    {
+        sink.Write(cell_open);
+        switch (kind)
+        {
+        case Doubles:   WriteNumber(sink, doubles[row], format);        break;
+        case Integers:  WriteNumber(sink, integers[row]);               break;
+        default:        WriteEscaped<false>(sink, strings[row]);        break;
+        }
+        sink.Write("</td>", 5);
+    }
+
+    std::size_t CellSize(std::size_t row) const
+    {
+        std::size_t size = cell_open.size() + 5;
+
+        switch (kind)
+        {
+        case Doubles:   return size + NumberSize(doubles[row], format);
+        case Integers:  return size + NumberSize(integers[row]);
+        default:        return size + EscapedSize<false>(strings[row]);
+        }
+    }
+
+    /// Continues seed over the header, cell tags and values.
+    std::uint64_t   Hash(std::uint64_t seed) const
+    {
+        std::uint64_t   h = HashBytes(HashBytes(seed ^ kind, header), cell_open);
+
+        switch (kind)
+        {
+        case Doubles:   return HashBytes(h ^ std::uint64_t(format.precision), doubles.data(), doubles.size() * sizeof(double));
+        case Integers:  return HashBytes(h, integers.data(), integers.size() * sizeof(std::int64_t));
+        default:
+            for (auto &s : strings)
+            {
+                h = HashBytes(h, s);
+            }
+            return h;
+        }
+    }
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The ColumnTable class renders a table straight from columns of values, <table></table>.
+ *
+ * The output is the same as a Table of TableRow, TableHeaderElement and
+ * TableElement nodes, but no node is created per row or cell and numbers
+ * are formatted while writing:
+ *
+ *      auto    table = Get<ColumnTable>("Metrics");
+ *      body->AppendChild(table);
+ *      table->AppendColumn("Name", names);
+ *      table->AppendColumn("Mean", means, NumberFormat{3}, "number");
+ *
+ * All columns must have the same number of rows. String columns only keep
+ * views, so the strings must outlive the table.
+ */
+class   ColumnTable : public NodeBase
+{
+    std::vector<TableColumn>    columns;
+    std::size_t                 rows{0};
+
+    bool    HasHeader() const
+    {
+        for (auto &c : columns)
+        {
+            if (!c.Header().empty())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void    Append(TableColumn column)
+    {
+        if (!columns.empty() && column.size() != rows)
+        {
+            throw std::invalid_argument("simple_html::ColumnTable: columns must have the same number of rows");
+        }
+
+        Touch();
+        rows = column.size();
+        columns.push_back(std::move(column));
+    }
+
+protected:
+    std::uint64_t   HashContent() override
+    {
+        std::uint64_t   h = rows;
+
+        for (auto &c : columns)
+        {
+            h = c.Hash(h);
+        }
+
+        return h;
+    }
+
+    void    WriteClose(Sink &sink, int indentation) override
+    {
+        bool    header = HasHeader();
+
+        for (std::size_t r = header ? 0 : 1; r <= rows; ++r)
+        {
+            sink.Newline();
+            sink.Indent(indentation + 1);
+            sink.Write("<tr>", 4);
+
+            for (auto &c : columns)
+            {
+                sink.Newline();
+                sink.Indent(indentation + 2);
+                if (r == 0)
+                {
+                    c.WriteHeader(sink);
+                }
+                else
+                {
+                    c.WriteCell(sink, r - 1);
+                }
+            }
+
+            sink.Newline();
+            sink.Indent(indentation + 1);
+            sink.Write("</tr>", 5);
+        }
+
+        NodeBase::WriteClose(sink, indentation);
+    }
+
+    std::size_t CloseSize(const Layout &layout, int indentation) override
+    {
+        bool        header = HasHeader();
+        std::size_t row_count = rows + (header ? 1 : 0);
+        std::size_t size = row_count * (2 * (layout.NewlineSize() + layout.IndentSize(indentation + 1)) + 9);
+
+        size += row_count * columns.size() * (layout.NewlineSize() + layout.IndentSize(indentation + 2));
+        for (auto &c : columns)
+        {
+            size += header ? c.HeaderSize() : 0;
+            for (std::size_t r = 0; r < rows; ++r)
+            {
+                size += c.CellSize(r);
+            }
+        }
+
+        return size + NodeBase::CloseSize(layout, indentation);
+    }
+
+public:
+    ColumnTable()
+        : NodeBase(tags::table)
+    {
+#ifdef __DEBUG
+        std::cout << "Constructing ColumnTable" << std::endl;
+#endif
+    }
+
+    ColumnTable(std::string caption)
+        : NodeBase(tags::table)
+    {
+        AppendChild(simple_html::Get<NodeBase>(tags::caption, std::move(caption)));
+#ifdef __DEBUG
+        std::cout << "Constructing ColumnTable" << std::endl;
+#endif
+    }
+
+    virtual ~ColumnTable()
+    {
+#ifdef __DEBUG
+        std::cout << "Destructing ColumnTable" << std::endl;
+#endif
+    }
+
+    ColumnTable&    AppendColumn(std::string header, std::vector<double> values, NumberFormat format = NumberFormat(), const std::string &class_name = "")
+    {
+        Append(TableColumn(std::move(header), std::move(values), format, class_name));
+        return *this;
+    }
+
+    ColumnTable&    AppendColumn(std::string header, std::vector<std::int64_t> values, const std::string &class_name = "")
+    {
+        Append(TableColumn(std::move(header), std::move(values), class_name));
+        return *this;
+    }
+
+    ColumnTable&    AppendColumn(std::string header, std::vector<std::string_view> values, const std::string &class_name = "")
+    {
+        Append(TableColumn(std::move(header), std::move(values), class_name));
+        return *this;
+    }
+
+    std::size_t Rows() const {return rows;}
+    const std::vector<TableColumn>& Columns() const {return columns;}
+};
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+/**
+ * @brief AppendUnescaped appends text to out with character references like &amp;, &#60; and &#x3C; decoded.
+ *
+ * Numeric references and the common named ones are decoded; anything else is
+ * copied unchanged.
+ */
+inline  void    AppendUnescaped(std::string &out, std::string_view text)
+{
+    static const std::pair<std::string_view, std::string_view>  named[] = {
+        {"amp", "&"}, {"lt", "<"}, {"gt", ">"}, {"quot", "\""}, {"apos", "'"},
+        {"nbsp", "\xC2\xA0"}, {"copy", "\xC2\xA9"}, {"reg", "\xC2\xAE"},
+        {"ndash", "\xE2\x80\x93"}, {"mdash", "\xE2\x80\x94"}, {"hellip", "\xE2\x80\xA6"}
+    };
+
+    const char  *first = text.data();
+    const char  *last = first + text.size();
+
+    while (first != last)
+    {
+        const char  *amp = static_cast<const char*>(std::memchr(first, '&', std::size_t(last - first)));
+        if (amp == nullptr)
+        {
+            out.append(first, last);
+            break;
+        }
+
+        out.append(first, amp);
+        first = amp + 1;
+
+        // The longest reference decoded is "&#x10FFFF;".
+        const char  *semicolon = static_cast<const char*>(std::memchr(first, ';', std::min<std::size_t>(std::size_t(last - first), 10)));
+        if (semicolon == nullptr)
+        {
+            out += '&';
+            continue;
+        }
+
+        std::string_view    reference(first, std::size_t(semicolon - first));
+        bool                decoded = false;
+
+        if (reference.size() > 1 && reference[0] == '#')
+        {
+            bool                hex = reference[1] == 'x' || reference[1] == 'X';
+            std::string_view    digits = reference.substr(hex ? 2 : 1);
+            std::uint32_t       code = 0;
+            auto                result = std::from_chars(digits.data(), digits.data() + digits.size(), code, hex ? 16 : 10);
+
+            if (!digits.empty() && result.ec == std::errc() && result.ptr == digits.data() + digits.size())
+            {
+                if (code == 0 || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+                {
+                    code = 0xFFFD;
+                }
+
+                if (code < 0x80)
+                {
+                    out += char(code);
+                }
+                else if (code < 0x800)
+                {
+                    out += char(0xC0 | (code >> 6));
+                    out += char(0x80 | (code & 0x3F));
+                }
+                else if (code < 0x10000)
+                {
+                    out += char(0xE0 | (code >> 12));
+                    out += char(0x80 | ((code >> 6) & 0x3F));
+                    out += char(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    out += char(0xF0 | (code >> 18));
+                    out += char(0x80 | ((code >> 12) & 0x3F));
+                    out += char(0x80 | ((code >> 6) & 0x3F));
+                    out += char(0x80 | (code & 0x3F));
+                }
+                decoded = true;
+            }
+        }
+        else
+        {
+            for (auto &n : named)
+            {
+                if (n.first == reference)
+                {
+                    out.append(n.second);
+                    decoded = true;
+                    break;
+                }
+            }
+        }
+
+        if (decoded)
+        {
+            first = semicolon + 1;
+        }
+        else
+        {
+            out += '&';
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The HtmlParser class builds a tree of the element classes above from HTML text.
+ *
+ * Known tags get their classes (<p> a Paragraph, <a> a Link, <img> an Image,
+ * <td> a TableElement ...), other void elements a Void and other phrasing
+ * elements a NodeInline; everything else is a NodeBase. Attributes are kept in
+ * order with their entities decoded. The first text inside an element becomes
+ * its value, later text becomes Text children.
+ *
+ * Text is kept exactly, whitespace included, except for the newlines and
+ * indentation that Get() writes in the layout given to the parser: a newline
+ * and indentation in front of a block's value, in front of a block child and
+ * in front of a block's end tag are dropped only where they match that layout
+ * exactly. Parsing the output of Get() therefore gives the same tree again,
+ * and with Layout::Minified() no whitespace is dropped at all. Script and
+ * style content, comments and other <!...> markup are kept verbatim as RawText.
+ *
+ * Like a browser the parser never fails: end tags close any elements left open
+ * inside them, stray end tags are ignored, and <li>, <p>, <td>, <th> and <tr>
+ * are closed implicitly.
+ *
+ * Names outside tags:: and the common attribute names are not added to the
+ * global pools of InternTagName() and InternAttributeName(), which would take
+ * a lock and grow for good on untrusted input. Each Parse() keeps them in a
+ * table of its own that the nodes using them share, so it is freed with them.
+ */
+class   HtmlParser
+{
+    class   Open
+    {
+    public:
+        NodeBase    *node;
+        bool        takes_value;
+    };
+
+    /// The tag and attribute names of one Parse() that have no global instance.
+    class   Names
+    {
+    public:
+        std::unordered_map<std::string, std::unique_ptr<OwnedTagName>>  tags;
+        std::unordered_map<std::string, std::unique_ptr<AttributeName>> attributes;
+    };
+
+    Layout              layout;
+    std::shared_ptr<Names>  names;      // created on the first name that needs it
+    std::vector<std::shared_ptr<NodeBase>>  *roots{nullptr};
+    std::vector<Open>   open;
+    std::size_t         floor{0};       // open[0, floor) is the caller's parent, see ParseInto()
+    bool                doctype{false};
+    std::string         name;           // lower-case tag or attribute name being parsed
+    std::string         pending;        // text in front of stray end tags, which do not end a text
+
+    static bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+    }
+
+    static bool IsAlpha(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    static bool IsNameEnd(char c)
+    {
+        return IsSpace(c) || c == '>' || c == '/';
+    }
+
+    static char Lower(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+    }
+
+    static bool IsOneOf(std::string_view name, std::initializer_list<std::string_view> names)
+    {
+        return std::find(names.begin(), names.end(), name) != names.end();
+    }
+
+    /// Returns the start of the end tag </tag> in [first, last), or last.
+    static const char*  FindEndTag(const char *first, const char *last, std::string_view tag)
+    {
+        while ((first = static_cast<const char*>(std::memchr(first, '<', std::size_t(last - first)))) != nullptr)
+        {
+            const char  *end = first + 2 + tag.size();
+
+            if (end <= last && first[1] == '/' && (end == last || IsNameEnd(*end)) &&
+                std::equal(tag.begin(), tag.end(), first + 2, [](char a, char b) {return a == Lower(b);}))
+            {
+                return first;
+            }
+            ++first;
+        }
+
+        return last;
+    }
+
+    /// Returns the position after the next '>' in [first, last), or last.
+    static const char*  SkipTag(const char *first, const char *last)
+    {
+        const char  *gt = static_cast<const char*>(std::memchr(first, '>', std::size_t(last - first)));
+
+        return gt == nullptr ? last : gt + 1;
+    }
+
+    /// The TagName for name, from tags:: or else from names, in which case owned is set.
+    const TagName&  ParsedTagName(const std::string &name, bool &owned)
+    {
+        if (auto t = StandardTagName(name))
+        {
+            return *t;
+        }
+
+        if (!names)
+        {
+            names = std::make_shared<Names>();
+        }
+        auto    &entry = names->tags[name];
+        if (!entry)
+        {
+            entry.reset(new OwnedTagName(name));
+        }
+        owned = true;
+
+        return entry->tag;
+    }
+
+    /// The AttributeName for name, a common one or else from names, in which case owned is set.
+    const AttributeName&    ParsedAttributeName(const std::string &name, bool &owned)
+    {
+        if (auto c = CommonAttributeName(name))
+        {
+            return *c;
+        }
+
+        if (!names)
+        {
+            names = std::make_shared<Names>();
+        }
+        auto    &entry = names->attributes[name];
+        if (!entry)
+        {
+            entry.reset(new AttributeName(name));
+        }
+        owned = true;
+
+        return *entry;
+    }
+
+    /// node, sharing its ownership with names so they live as long as node refers to them.
+    std::shared_ptr<NodeBase>   KeepNames(const std::shared_ptr<NodeBase> &node) const
+    {
+        auto    owner = std::make_shared<std::pair<std::shared_ptr<NodeBase>, std::shared_ptr<const Names>>>(node, names);
+
+        return std::shared_ptr<NodeBase>(owner, node.get());
+    }
+
+    const std::string&  LowerName(const char *first, const char *last)
+    {
+        name.assign(first, last);
+        for (auto &c : name)
+        {
+            c = Lower(c);
+        }
+
+        return name;
+    }
+
+    std::shared_ptr<NodeBase>   Create(const TagName &tag)
+    {
+        static const TagName    *headings[] = {&tags::h1, &tags::h2, &tags::h3, &tags::h4, &tags::h5, &tags::h6};
+
+        if (&tag == &tags::p)       return simple_html::Get<Paragraph>();
+        if (&tag == &tags::div)     return simple_html::Get<Div>();
+        if (&tag == &tags::span)    return simple_html::Get<Span>();
+        if (&tag == &tags::a)       return simple_html::Get<Link>();
+        if (&tag == &tags::img)     return simple_html::Get<Image>();
+        if (&tag == &tags::br)      return simple_html::Get<Break>();
+        if (&tag == &tags::td)      return simple_html::Get<TableElement>();
+        if (&tag == &tags::th)      return simple_html::Get<TableHeaderElement>();
+        if (&tag == &tags::tr)      return simple_html::Get<TableRow>();
+        if (&tag == &tags::table)   return simple_html::Get<Table>();
+        if (&tag == &tags::li)      return simple_html::Get<ListItem>();
+        if (&tag == &tags::ul)      return simple_html::Get<UnorderedList>();
+        if (&tag == &tags::ol)      return simple_html::Get<OrderedList>();
+        if (&tag == &tags::sub)     return simple_html::Get<SubScript>();
+        if (&tag == &tags::sup)     return simple_html::Get<SuperScript>();
+        if (&tag == &tags::title)   return simple_html::Get<Title>("");
+        if (&tag == &tags::head)    return simple_html::Get<Head>();
+        if (&tag == &tags::body)    return simple_html::Get<Body>();
+        if (&tag == &tags::html)    return doctype ? simple_html::Get<Document>() : simple_html::Get<NodeBase>(tag);
+
+        for (int level = 1; level <= 6; ++level)
+        {
+            if (&tag == headings[level - 1])
+            {
+                return simple_html::Get<Heading>("", level);
+            }
+        }
+
+        if (&tag == &tags::link || IsOneOf(tag.name, {"area", "base", "col", "embed", "hr", "meta", "param", "source", "track"}))
+        {
+            return simple_html::Get<Void>(tag);
+        }
+
+        if (IsOneOf(tag.name, {"input", "wbr"}))
+        {
+            auto    node = simple_html::Get<Void>(tag);
+            node->_is_inline = true;
+            return node;
+        }
+
+        if (IsOneOf(tag.name, {"script", "style"}))
+        {
+            return simple_html::Get<NodeLine>(tag);
+        }
+
+        if (IsOneOf(tag.name, {"abbr", "b", "bdi", "bdo", "button", "cite", "code", "data", "dfn", "em", "font", "i",
+                               "kbd", "label", "mark", "q", "s", "samp", "small", "strike", "strong", "textarea",
+                               "time", "tt", "u", "var"}))
+        {
+            return simple_html::Get<NodeInline>(tag);
+        }
+
+        return simple_html::Get<NodeBase>(tag);
+    }
+
+    void    Append(std::shared_ptr<NodeBase> node)
+    {
+        if (open.empty())
+        {
+            roots->push_back(std::move(node));
+        }
+        else
+        {
+            open.back().node->AppendChild(node);
+        }
+    }
+
+    /// Whether Get() puts a newline between the start tag and the content and before the end tag.
+    static bool IsBlock(NodeBase *node)
+    {
+        return !node->is_inline() && dynamic_cast<NodeLine*>(node) == nullptr;
+    }
+
+    /// The indentation Get() writes the open element open[i] at.
+    int     Indentation(std::size_t i) const
+    {
+        return int(i - floor);
+    }
+
+    /// What Get() writes in front of a child: the newline if newline is set, then the indentation.
+    std::string LayoutText(bool newline, int indentation) const
+    {
+        std::string result(newline ? layout.NewlineSize() : 0, '\n');
+
+        result.append(layout.IndentSize(indentation), layout.indent_char);
+
+        return result;
+    }
+
+    /**
+     * Appends [first, last) as the value of the current element or as a Text.
+     * Where Get() writes a newline and indentation, exactly that is dropped:
+     * in front of a block's value, and at the end where end_layout is given
+     * (before a block child or a block's end tag). Other whitespace is kept.
+     */
+    void    AppendText(const char *first, const char *last, const std::string *end_layout)
+    {
+        if (!pending.empty())
+        {
+            pending.append(first, last);
+            first = pending.data();
+            last = first + pending.size();
+        }
+
+        NodeBase    *node = open.empty() ? nullptr : open.back().node;
+        bool        value = node != nullptr && open.back().takes_value && node->children.empty() && node->value.empty();
+        std::size_t size = std::size_t(last - first);
+
+        if (value && IsBlock(node))
+        {
+            std::string begin_layout = LayoutText(true, Indentation(open.size() - 1) + 1);
+
+            if (size >= begin_layout.size() && std::memcmp(first, begin_layout.data(), begin_layout.size()) == 0)
+            {
+                first += begin_layout.size();
+                size -= begin_layout.size();
+            }
+        }
+        if (end_layout != nullptr && size >= end_layout->size() &&
+            std::memcmp(last - end_layout->size(), end_layout->data(), end_layout->size()) == 0)
+        {
+            last -= end_layout->size();
+        }
+
+        std::string text;
+        AppendUnescaped(text, std::string_view(first, std::size_t(last - first)));
+        pending.clear();
+
+        if (text.empty())
+        {
+            return;
+        }
+
+        if (value)
+        {
+            node->SetValue(std::move(text));
+        }
+        else
+        {
+            Append(simple_html::Get<Text>(std::move(text)));
+        }
+    }
+
+    /// Closes the open elements that a start tag for name ends implicitly.
+    void    CloseImplicitly(std::string_view name)
+    {
+        while (open.size() > floor)
+        {
+            std::string_view    current = open.back().node->Tag().name;
+            bool                closes = false;
+
+            if (current == "p")
+            {
+                closes = IsOneOf(name, {"address", "article", "aside", "blockquote", "div", "dl", "fieldset", "footer",
+                                        "form", "h1", "h2", "h3", "h4", "h5", "h6", "header", "hr", "li", "main", "nav",
+                                        "ol", "p", "pre", "section", "table", "ul"});
+            }
+            else if (current == "li")
+            {
+                closes = name == "li";
+            }
+            else if (current == "td" || current == "th")
+            {
+                closes = name == "td" || name == "th" || name == "tr";
+            }
+            else if (current == "tr")
+            {
+                closes = name == "tr";
+            }
+
+            if (!closes)
+            {
+                break;
+            }
+            open.pop_back();
+        }
+    }
+
+    /// Returns the number of open elements outside the innermost one named name, or open.size() if none is.
+    std::size_t FindOpen(std::string_view name)
+    {
+        for (std::size_t i = open.size(); i > floor; --i)
+        {
+            if (open[i - 1].node->Tag().name == name)
+            {
+                return i - 1;
+            }
+        }
+
+        return open.size();
+    }
+
+    /// Parses the start tag at first (just after '<') and returns the position after it; [text, first - 1) is the text before it.
+    const char* StartTag(const char *text, const char *first, const char *last)
+    {
+        const char  *p = first;
+        while (p != last && !IsNameEnd(*p))
+        {
+            ++p;
+        }
+
+        bool            owned = false;      // whether node refers to names
+        const TagName   &tag = ParsedTagName(LowerName(first, p), owned);
+        auto            node = Create(tag);
+
+        if (node->is_inline())
+        {
+            AppendText(text, first - 1, nullptr);
+        }
+        else
+        {
+            // The parent's separator, if it writes one for a block child, or the newline
+            // Document writes after the doctype, and the child's indentation.
+            bool        newline = open.size() > floor ? open.back().node->SeparatorSize(layout, *node) > 0
+                                                      : doctype && &tag == &tags::html;
+            std::string child_layout = LayoutText(newline, Indentation(open.size()));
+
+            AppendText(text, first - 1, &child_layout);
+        }
+
+        CloseImplicitly(tag.name);
+
+        bool    self_closing = false;
+
+        while (p != last)
+        {
+            if (IsSpace(*p))
+            {
+                ++p;
+                continue;
+            }
+            if (*p == '>')
+            {
+                ++p;
+                break;
+            }
+            if (*p == '/')
+            {
+                if (++p != last && *p == '>')
+                {
+                    self_closing = true;
+                    ++p;
+                    break;
+                }
+                continue;
+            }
+
+            const char  *name_first = p;
+            do
+            {
+                ++p;
+            } while (p != last && !IsSpace(*p) && *p != '=' && *p != '>' && *p != '/');
+            const char  *name_last = p;
+
+            while (p != last && IsSpace(*p))
+            {
+                ++p;
+            }
+
+            const char  *value_first = p;
+            const char  *value_last = p;
+
+            if (p != last && *p == '=')
+            {
+                ++p;
+                while (p != last && IsSpace(*p))
+                {
+                    ++p;
+                }
+
+                if (p != last && (*p == '"' || *p == '\''))
+                {
+                    const char  *quote = static_cast<const char*>(std::memchr(p + 1, *p, std::size_t(last - p - 1)));
+
+                    value_first = p + 1;
+                    value_last = quote == nullptr ? last : quote;
+                    p = quote == nullptr ? last : quote + 1;
+                }
+                else
+                {
+                    value_first = p;
+                    while (p != last && !IsSpace(*p) && *p != '>')
+                    {
+                        ++p;
+                    }
+                    value_last = p;
+                }
+            }
+
+            std::string value;
+            AppendUnescaped(value, std::string_view(value_first, std::size_t(value_last - value_first)));
+            node->Touch();
+            node->IndexAttribute(node->attributes.Append(ParsedAttributeName(LowerName(name_first, name_last), owned), std::move(value)));
+        }
+
+        if (owned)
+        {
+            node = KeepNames(node);
+        }
+        Append(node);
+
+        if (!node->_renders_children || self_closing)
+        {
+            return p;
+        }
+
+        if (IsOneOf(tag.name, {"script", "style"}))
+        {
+            const char  *end = FindEndTag(p, last, tag.name);
+            if (end != p)
+            {
+                node->AppendChild(simple_html::Get<RawText>(std::string(p, end)));
+            }
+            return SkipTag(end, last);
+        }
+
+        if (IsOneOf(tag.name, {"title", "textarea"}))
+        {
+            const char  *end = FindEndTag(p, last, tag.name);
+            std::string text;
+
+            AppendUnescaped(text, std::string_view(p, std::size_t(end - p)));
+            node->SetValue(std::move(text));
+            return SkipTag(end, last);
+        }
+
+        open.push_back({node.get(), true});
+
+        return p;
+    }
+
+    void    Run(std::string_view html)
+    {
+        const char  *last = html.data() + html.size();
+        const char  *text = html.data();        // start of text not yet appended
+        const char  *position = text;
+
+        while (position != last)
+        {
+            const char  *lt = static_cast<const char*>(std::memchr(position, '<', std::size_t(last - position)));
+            if (lt == nullptr || lt + 1 == last)
+            {
+                break;
+            }
+
+            position = lt + 1;
+            char    c = *position;
+
+            if (c == '!' || c == '?')
+            {
+                // Unterminated markup runs to the end and is closed, so it does not swallow what is written after it.
+                std::string_view    terminator = ">";
+                if (last - lt >= 4 && std::memcmp(lt, "<!--", 4) == 0)
+                {
+                    terminator = "-->";
+                    position = std::search(lt + 4, last, terminator.begin(), terminator.end());
+                }
+                else
+                {
+                    position = std::find(position, last, '>');
+                }
+                bool    terminated = position != last;
+                position = terminated ? position + terminator.size() : last;
+
+                // The doctype is written by Document, so like a stray end tag it is dropped.
+                if (position - lt >= 9 && LowerName(lt, lt + 9) == "<!doctype")
+                {
+                    doctype = true;
+                    pending.append(text, lt);
+                }
+                else
+                {
+                    AppendText(text, lt, nullptr);
+
+                    std::string markup(lt, position);
+                    if (!terminated)
+                    {
+                        markup.append(terminator);
+                    }
+                    Append(simple_html::Get<RawText>(std::move(markup)));
+                }
+            }
+            else if (c == '/' && position + 1 != last && IsAlpha(position[1]))
+            {
+                const char  *p = position + 1;
+                while (p != last && !IsNameEnd(*p))
+                {
+                    ++p;
+                }
+
+                // Stray end tags are ignored; others close everything inside the element too.
+                std::size_t closed = FindOpen(LowerName(position + 1, p));
+                if (closed == open.size())
+                {
+                    pending.append(text, lt);
+                }
+                else
+                {
+                    std::string end_layout = LayoutText(true, Indentation(open.size() - 1));
+
+                    AppendText(text, lt, IsBlock(open.back().node) ? &end_layout : nullptr);
+                    open.resize(closed);
+                }
+                position = SkipTag(p, last);
+            }
+            else if (IsAlpha(c))
+            {
+                position = StartTag(text, position, last);
+            }
+            else
+            {
+                // A '<' that starts no tag is text.
+                continue;
+            }
+
+            text = position;
+        }
+
+        AppendText(text, last, nullptr);
+    }
+public:
+    /// A parser for HTML written in layout, the layout whose newlines and indentation are dropped.
+    HtmlParser(const simple_html::Layout &layout = simple_html::Layout())
+        : layout(layout)
+    {
+    }
+
+    /// Parses a fragment or document; returns its top-level nodes.
+    std::vector<std::shared_ptr<NodeBase>>  Parse(std::string_view html)
+    {
+        std::vector<std::shared_ptr<NodeBase>>  result;
+
+        roots = &result;
+        open.clear();
+        names.reset();
+        pending.clear();
+        floor = 0;
+        doctype = false;
+
+        Run(html);
+
+        open.clear();
+        roots = nullptr;
+
+        return result;
+    }
+
+    /// Parses a fragment and appends its nodes to parent, e.g. a Body or Div.
+    NodeBase&   ParseInto(NodeBase &parent, std::string_view html)
+    {
+        roots = nullptr;
+        open.assign(1, {&parent, false});
+        names.reset();
+        pending.clear();
+        floor = 1;
+        doctype = false;
+
+        Run(html);
+
+        open.clear();
+
+        return parent;
+    }
+};
+
+inline  std::vector<std::shared_ptr<NodeBase>>  ParseHtml(std::string_view html, const Layout &layout = Layout())
+{
+    return HtmlParser(layout).Parse(html);
+}
+
+#ifdef SIMPLE_HTML_HAS_POSIX
+/**
+ * @brief ParseHtmlFile parses the file at path through a read-only memory mapping.
+ *
+ * Throws std::system_error if the file cannot be opened or mapped.
+ */
+inline  std::vector<std::shared_ptr<NodeBase>>  ParseHtmlFile(const std::string &path, const Layout &layout = Layout())
+{
+    auto    fail = [](const char *operation)
+    {
+        throw std::system_error(errno, std::generic_category(), std::string("simple_html::ParseHtmlFile: ") + operation);
+    };
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        fail("open");
+    }
+
+    std::unique_ptr<int, void(*)(int*)> closer(&fd, [](int *f) {::close(*f);});
+
+    struct stat status;
+    if (::fstat(fd, &status) == -1)
+    {
+        fail("fstat");
+    }
+
+    std::size_t size = std::size_t(status.st_size);
+    if (size == 0)
+    {
+        return {};
+    }
+
+    void    *view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED)
+    {
+        fail("mmap");
+    }
+    ::madvise(view, size, MADV_SEQUENTIAL);
+
+    std::vector<std::shared_ptr<NodeBase>>  result;
+    try
+    {
+        result = ParseHtml(std::string_view(static_cast<const char*>(view), size), layout);
+    }
+    catch (...)
+    {
+        ::munmap(view, size);
+        throw;
+    }
+    ::munmap(view, size);
+
+    return result;
+}
+#endif
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+/**
+ * @brief AppendJsonString appends text to out as a quoted JSON string.
+ */
+inline  void    AppendJsonString(std::string &out, std::string_view text)
+{
+    static const char   hex[] = "0123456789abcdef";
+
+    out += '"';
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '"':   out += "\\\"";  break;
+        case '\\':  out += "\\\\";  break;
+        case '\n':  out += "\\n";   break;
+        case '\r':  out += "\\r";   break;
+        case '\t':  out += "\\t";   break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                out.append("\\u00").append(1, hex[(c >> 4) & 0xf]).append(1, hex[c & 0xf]);
+            }
+            else
+            {
+                out += c;
+            }
+            break;
+        }
+    }
+    out += '"';
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Edit class is one step of a Patch.
+ */
+class   Edit
+{
+public:
+    enum    Operation
+    {
+        Replace,            ///< Replace the element at path by the HTML in value.
+        Insert,             ///< Insert the HTML in value in front of the element child at path, or append it if there is none.
+        Remove,             ///< Remove the element at path.
+        SetAttribute,       ///< Set attribute name of the element at path to value.
+        RemoveAttribute,    ///< Remove attribute name from the element at path.
+        SetText             ///< Replace the text in front of the first element child of the element at path by value.
+    };
+
+    Operation                   operation;
+    std::string                 id;         ///< Id of the element path starts from; empty for the root.
+    std::vector<std::size_t>    path;       ///< Element child indices (DOM children), from the element with id or the root.
+    std::string                 name;       ///< Attribute name.
+    std::string                 value;      ///< Attribute value, text or minified HTML.
+};
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Patch class is the list of edits that turns one tree into another.
+ *
+ * Pages pushed to a browser can be updated with the difference to the
+ * previous version instead of the full output:
+ *
+ *      Patch   patch(*previous, *current);
+ *      if (!patch.empty())
+ *      {
+ *          Send(patch.ToJson());
+ *      }
+ *
+ * Subtrees with equal Hash() are taken to be equal and skipped without
+ * looking inside, so with cached hashes the work is proportional to the
+ * change. Children are matched by skipping equal ones at both ends, then
+ * pairwise; nodes of another class or tag are replaced as a whole.
+ *
+ * Edits apply in order to the DOM the browser built from the output of from,
+ * each to the DOM as left by the edits before it. Paths count element
+ * children only, like Element.children, so they do not depend on the layout
+ * whitespace; a client resolves them as
+ *
+ *      let node = edit.id ? document.getElementById(edit.id) : root;
+ *      for (const i of edit.path) node = node.children[i];     // the last step of an insert is the position
+ *
+ * Text has no element to address: an element's value is the text in front of
+ * its first element child, changed with set_text, and an element whose Text
+ * children change is replaced as a whole. Repeated attributes count as the
+ * first one, as in the DOM. When from and to are Documents, a path starts at
+ * the nearest enclosing element whose id is unchanged and unique in both.
+ */
+class   Patch
+{
+    // Paths are kept as links to the parent's step, so going deeper does not copy them.
+    class   Step
+    {
+    public:
+        std::size_t         up;
+        std::size_t         index;
+        const std::string   *id;        ///< Set where paths restart at a node with a unique id.
+    };
+
+    class   Work
+    {
+    public:
+        NodeBase    *from;
+        NodeBase    *to;
+        std::size_t step;
+    };
+
+    std::vector<Edit>   edits;
+    std::vector<Step>   steps{{0, 0, nullptr}};
+    Document            *document{nullptr};
+    Document            *to_document{nullptr};
+
+    /// Adds an edit for the node at step, or for its child child if that is not npos.
+    void    Add(Edit::Operation operation, std::size_t step, std::size_t child, std::string name, std::string value)
+    {
+        Edit    edit{operation, "", {}, std::move(name), std::move(value)};
+
+        if (child != std::string::npos)
+        {
+            edit.path.push_back(child);
+        }
+        for (; step != 0 && steps[step].id == nullptr; step = steps[step].up)
+        {
+            edit.path.push_back(steps[step].index);
+        }
+        if (steps[step].id != nullptr)
+        {
+            edit.id = *steps[step].id;
+        }
+        std::reverse(edit.path.begin(), edit.path.end());
+
+        edits.push_back(std::move(edit));
+    }
+
+    static std::string  AttributeValue(const AttributeEntry &a)
+    {
+        char    number[number_buffer_size];
+
+        switch (a.kind)
+        {
+        case AttributeEntry::Integer:   return std::string(number, FormatNumber(number, a.integer));
+        case AttributeEntry::Number:    return std::string(number, FormatNumber(number, a.number, a.format));
+        default:                        return a.value;
+        }
+    }
+
+    /// The first attribute called name, the one a browser keeps; nullptr if there is none.
+    static const AttributeEntry*    FindAttribute(const NodeBase &node, const AttributeName &name)
+    {
+        for (std::size_t i = 0; i < node.attributes.size(); ++i)
+        {
+            if (node.attributes[i].name == &name || node.attributes[i].name->name == name.name)
+            {
+                return &node.attributes[i];
+            }
+        }
+
+        return nullptr;
+    }
+
+    /// Whether id is the id of node alone in document.
+    static bool UniqueId(Document &document, NodeBase &node, const std::string &id)
+    {
+        auto    &duplicates = document.DuplicateIds();
+
+        return document.FindById(id) == &node && std::find(duplicates.begin(), duplicates.end(), id) == duplicates.end();
+    }
+
+    /// Text and the like write no element, so there is no DOM element to address them by.
+    static bool IsText(const NodeBase &node)
+    {
+        return node.tag == &tags::text;
+    }
+
+    /// The number of element children among children[0, end).
+    static std::size_t ElementIndex(const std::vector<std::shared_ptr<NodeBase>> &children, std::size_t end)
+    {
+        std::size_t elements = 0;
+
+        for (std::size_t i = 0; i < end; ++i)
+        {
+            elements += IsText(*children[i]) ? 0 : 1;
+        }
+
+        return elements;
+    }
+
+    /// Whether from can be turned into to by changing attributes, value and children.
+    static bool Compatible(NodeBase &from, NodeBase &to)
+    {
+        return typeid(from) == typeid(to) && from.tag->name == to.tag->name &&
+               from._is_inline == to._is_inline && from._renders_children == to._renders_children &&
+               from.HashContent() == to.HashContent() &&
+               (dynamic_cast<RawText*>(&from) == nullptr || from.value == to.value);
+    }
+
+    void    Compare(const Work &work, std::vector<Work> &pending)
+    {
+        NodeBase    &from = *work.from;
+        NodeBase    &to = *work.to;
+        std::size_t step = work.step;
+
+        // Equal children at both ends are skipped; the rest is compared pairwise.
+        auto        &a = from.children;
+        auto        &b = to.children;
+        std::size_t first = 0;
+        std::size_t a_last = to._renders_children ? a.size() : 0;
+        std::size_t b_last = to._renders_children ? b.size() : 0;
+
+        while (first < a_last && first < b_last && (a[first] == b[first] || a[first]->Hash() == b[first]->Hash()))
+        {
+            ++first;
+        }
+        while (a_last > first && b_last > first && (a[a_last - 1] == b[b_last - 1] || a[a_last - 1]->Hash() == b[b_last - 1]->Hash()))
+        {
+            --a_last;
+            --b_last;
+        }
+
+        std::size_t paired = std::min(a_last, b_last) - first;
+        bool        replace = !Compatible(from, to) || IsText(from);
+
+        // Changed Text children cannot be addressed, nor can a place in front
+        // of a Text child or text in front of the first element that is not
+        // only the value: the element is replaced instead.
+        for (std::size_t i = first; i < first + paired && !replace; ++i)
+        {
+            replace = (IsText(*a[i]) || IsText(*b[i])) && a[i]->Hash() != b[i]->Hash();
+        }
+        for (std::size_t i = first + paired; i < a_last && !replace; ++i)
+        {
+            replace = IsText(*a[i]);
+        }
+        for (std::size_t i = first + paired; i < b_last && !replace; ++i)
+        {
+            replace = IsText(*b[i]) || (b_last < b.size() && IsText(*b[b_last]));
+        }
+        if (!replace && from.value != to.value)
+        {
+            replace = (!a.empty() && IsText(*a.front())) || (!b.empty() && IsText(*b.front()));
+        }
+
+        if (replace)
+        {
+            Add(Edit::Replace, step, std::string::npos, "", to.Get(Layout::Minified()));
+            return;
+        }
+
+        // Deeper paths start at this node if the client can find it by id.
+        if (document != nullptr && to_document != nullptr)
+        {
+            const AttributeName     &id_name = InternAttributeName("id");
+            const AttributeEntry    *id = FindAttribute(from, id_name);
+            const AttributeEntry    *new_id = FindAttribute(to, id_name);
+
+            if (id != nullptr && new_id != nullptr && id->kind == AttributeEntry::Text && new_id->kind == AttributeEntry::Text &&
+                id->value == new_id->value && UniqueId(*document, from, id->value) && UniqueId(*to_document, to, id->value))
+            {
+                steps[step].id = &id->value;
+            }
+        }
+
+        for (std::size_t i = 0; i < to.attributes.size(); ++i)
+        {
+            const AttributeEntry    &a = to.attributes[i];
+
+            // Later repeats of a name are ignored, as by a browser.
+            if (FindAttribute(to, *a.name) != &a)
+            {
+                continue;
+            }
+
+            const AttributeEntry    *old = FindAttribute(from, *a.name);
+            std::string             value = AttributeValue(a);
+
+            if (old == nullptr || AttributeValue(*old) != value)
+            {
+                Add(Edit::SetAttribute, step, std::string::npos, a.name->name, std::move(value));
+            }
+        }
+        for (std::size_t i = 0; i < from.attributes.size(); ++i)
+        {
+            const AttributeEntry    &a = from.attributes[i];
+
+            if (FindAttribute(from, *a.name) == &a && FindAttribute(to, *a.name) == nullptr)
+            {
+                Add(Edit::RemoveAttribute, step, std::string::npos, a.name->name, "");
+            }
+        }
+
+        if (from.value != to.value)
+        {
+            Add(Edit::SetText, step, std::string::npos, "", to.value);
+        }
+
+        // Only elements are left in the changed ranges, apart from equal Text pairs.
+        std::size_t removed_at = ElementIndex(a, first + paired);
+
+        for (std::size_t i = first + paired; i < a_last; ++i)
+        {
+            Add(Edit::Remove, step, removed_at, "", "");
+        }
+        for (std::size_t i = first + paired; i < b_last; ++i)
+        {
+            Add(Edit::Insert, step, ElementIndex(b, i), "", b[i]->Get(Layout::Minified()));
+        }
+
+        std::size_t element = ElementIndex(b, first + paired);
+
+        for (std::size_t i = first + paired; i-- > first;)
+        {
+            if (IsText(*b[i]))
+            {
+                continue;
+            }
+
+            --element;
+            if (a[i] != b[i] && a[i]->Hash() != b[i]->Hash())
+            {
+                steps.push_back({step, element, nullptr});
+                pending.push_back({a[i].get(), b[i].get(), steps.size() - 1});
+            }
+        }
+    }
+
+public:
+    Patch(NodeBase &from, NodeBase &to)
+        : document(dynamic_cast<Document*>(&from)),
+          to_document(dynamic_cast<Document*>(&to))
+    {
+        std::vector<Work>   pending;
+
+        if (&from != &to && from.Hash() != to.Hash())
+        {
+            pending.push_back({&from, &to, 0});
+        }
+
+        // An explicit stack, so deep trees do not exhaust the call stack.
+        while (!pending.empty())
+        {
+            Work    work = pending.back();
+            pending.pop_back();
+            Compare(work, pending);
+        }
+    }
+
+    const std::vector<Edit>&    Edits() const {return edits;}
+    bool                        empty() const {return edits.empty();}
+
+    /**
+     * @brief ToJson returns the edits as a JSON array for a client to apply, e.g.
+     *
+     *      [{"op":"set_attribute","id":"summary","path":[0],"name":"class","value":"alert"},
+     *       {"op":"insert","path":[1,3],"value":"<li>new</li>"}]
+     *
+     * "id" and "name" are left out when empty; "value" is left out of remove
+     * and remove_attribute.
+     */
+    std::string ToJson() const
+    {
+        static const char   *operations[] = {"replace", "insert", "remove", "set_attribute", "remove_attribute", "set_text"};
+
+        std::string json = "[";
+
+        for (auto &e : edits)
+        {
+            if (json.size() > 1)
+            {
+                json += ',';
+            }
+
+            json.append("{\"op\":\"").append(operations[e.operation]).append("\"");
+            if (!e.id.empty())
+            {
+                json += ",\"id\":";
+                AppendJsonString(json, e.id);
+            }
+
+            json += ",\"path\":[";
+            for (std::size_t i = 0; i < e.path.size(); ++i)
+            {
+                char    number[number_buffer_size];
+
+                if (i > 0)
+                {
+                    json += ',';
+                }
+                json.append(number, FormatNumber(number, e.path[i]));
+            }
+            json += ']';
+
+            if (!e.name.empty())
+            {
+                json += ",\"name\":";
+                AppendJsonString(json, e.name);
+            }
+            if (e.operation != Edit::Remove && e.operation != Edit::RemoveAttribute)
+            {
+                json += ",\"value\":";
+                AppendJsonString(json, e.value);
+            }
+            json += '}';
+        }
+        json += ']';
+
+        return json;
+    }
+};
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+/**
+ * @brief The NodeInterner class lets equal nodes share a single instance.
+ *
+ * Intern() freezes the node and returns the equal node interned before it, or
+ * the node itself if it is the first of its kind. Nodes are equal when they
+ * have the same type, tag, value and attributes and the very same children,
+ * so interning cells before their rows shares whole rows as well. Repeated
+ * cells, icons and breaks then take one node however often they are
+ * appended, and the output does not change. A node is returned unshared and
+ * not frozen if it or any node below it has an id, which must stay unique in
+ * the page and be found by FindById(), or content of its own such as a
+ * ColumnTable or Slot. Not thread safe; use one interner per thread or lock
+ * around it.
+ *
+ *      NodeInterner    cells;
+ *
+ *      row->AppendChild(cells.Get<TableElement>("OK"));
+ *      row->AppendChild(cells.Get<Image>("ok.png", "OK", 16, 16));
+ */
+class   NodeInterner
+{
+    std::unordered_multimap<std::uint64_t, std::shared_ptr<NodeBase>>   nodes;
+
+    /// Whether no node in the subtree has an id or content of its own.
+    static bool Shareable(NodeBase &node)
+    {
+        const AttributeName *id = &InternAttributeName("id");
+        bool                shareable = true;
+
+        node.ForEachNode([&](NodeBase &n)
+        {
+            for (std::size_t i = 0; shareable && i < n.attributes.size(); ++i)
+            {
+                shareable = n.attributes[i].name != id;
+            }
+            shareable = shareable && n.HashContent() == 0;
+
+            return shareable;
+        });
+
+        return shareable;
+    }
+
+    static bool Equal(const AttributeEntry &a, const AttributeEntry &b)
+    {
+        if (a.name != b.name || a.kind != b.kind)
+        {
+            return false;
+        }
+
+        switch (a.kind)
+        {
+        case AttributeEntry::Integer:   return a.integer == b.integer;
+        case AttributeEntry::Number:    return a.format.precision == b.format.precision &&
+                                               std::memcmp(&a.number, &b.number, sizeof(a.number)) == 0;
+        default:                        return a.value == b.value;
+        }
+    }
+
+    static bool Equal(const NodeBase &a, const NodeBase &b)
+    {
+        if (typeid(a) != typeid(b) || a.tag != b.tag || a._is_inline != b._is_inline ||
+            a._renders_children != b._renders_children || a.value != b.value ||
+            a.attributes.size() != b.attributes.size() || a.children != b.children)
+        {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < a.attributes.size(); ++i)
+        {
+            if (!Equal(a.attributes[i], b.attributes[i]))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+public:
+    /// Returns the interned node equal to node, interning node if there is none.
+    template<typename T>
+    std::shared_ptr<T>  Intern(const std::shared_ptr<T> &node)
+    {
+        NodeBase    &n = *node;
+
+        if (!Shareable(n))
+        {
+            return node;
+        }
+
+        n.Freeze();
+
+        auto    range = nodes.equal_range(n.hash);
+        for (auto i = range.first; i != range.second; ++i)
+        {
+            if (Equal(*i->second, n))
+            {
+                return std::static_pointer_cast<T>(i->second);
+            }
+        }
+
+        nodes.emplace(n.hash, node);
+
+        return node;
+    }
+
+    /// Creates a T like simple_html::Get<T>() and interns it.
+    template<typename T, typename... Args>
+    std::shared_ptr<T>  Get(Args&&... args)
+    {
+        return Intern(simple_html::Get<T>(std::forward<Args>(args)...));
+    }
+
+    /// The number of distinct nodes interned.
+    std::size_t size() const {return nodes.size();}
+
+    /// Forgets the interned nodes; nodes already appended stay shared.
+    void    clear() {nodes.clear();}
 };
 
 } // namespace simple_html
@@ -0,0 +1,67 @@
+//----------------------------------------------------------------------------
+// Replaces the global operator new and delete to count allocations and the
+// bytes in use. Include in exactly one source file per test executable.
+//----------------------------------------------------------------------------
+#ifndef SIMPLE_HTML_TESTS_ALLOCATION_H
+#define SIMPLE_HTML_TESTS_ALLOCATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::size_t> allocation_count{0};
+static std::atomic<std::size_t> bytes_in_use{0};
+static std::atomic<std::size_t> peak_bytes_in_use{0};
+
+// Every block is prefixed with its size, so delete knows how much is freed.
+static const std::size_t    allocation_header = alignof(std::max_align_t);
+
+inline  void*   CountedAllocate(std::size_t size)
+{
+    char    *p = static_cast<char*>(std::malloc(size + allocation_header));
+
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    *reinterpret_cast<std::size_t*>(p) = size;
+    ++allocation_count;
+
+    std::size_t in_use = bytes_in_use += size;
+    std::size_t peak = peak_bytes_in_use;
+    while (in_use > peak && !peak_bytes_in_use.compare_exchange_weak(peak, in_use))
+    {
+    }
+
+    return p + allocation_header;
+}
+
+inline  void    CountedFree(void *p) noexcept
+{
+    if (p != nullptr)
+    {
+        char    *block = static_cast<char*>(p) - allocation_header;
+
+        bytes_in_use -= *reinterpret_cast<std::size_t*>(block);
+        std::free(block);
+    }
+}
+
+/// Restarts peak tracking at the current number of bytes in use and returns it.
+inline  std::size_t ResetPeak()
+{
+    std::size_t in_use = bytes_in_use;
+    peak_bytes_in_use = in_use;
+    return in_use;
+}
+
+void*   operator new(std::size_t size)                              {return CountedAllocate(size);}
+void*   operator new[](std::size_t size)                            {return CountedAllocate(size);}
+void    operator delete(void *p) noexcept                           {CountedFree(p);}
+void    operator delete[](void *p) noexcept                         {CountedFree(p);}
+void    operator delete(void *p, std::size_t) noexcept              {CountedFree(p);}
+void    operator delete[](void *p, std::size_t) noexcept            {CountedFree(p);}
+
+#endif  // SIMPLE_HTML_TESTS_ALLOCATION_H
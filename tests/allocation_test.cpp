@@ -0,0 +1,60 @@
+//----------------------------------------------------------------------------
+// Allocations per node: a string handed over by value is moved into the node,
+// so building a node costs its own allocation and nothing per string.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "allocation.h"
+#include "check.h"
+
+using namespace simple_html;
+
+// Longer than any small string buffer, so a copy would allocate.
+const std::string   long_text(100, 'x');
+
+/// The allocations build() makes, counted after the strings it moves are made.
+template<typename Build>
+std::size_t Allocations(Build build)
+{
+    std::string text = long_text;
+    std::string url = long_text;
+    std::size_t before = allocation_count;
+
+    build(std::move(text), std::move(url));
+
+    return allocation_count - before;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // One block for the node and its shared_ptr control block.
+    CHECK(Allocations([](std::string text, std::string) {Get<Text>(std::move(text));}) == 1);
+    CHECK(Allocations([](std::string text, std::string) {Get<Paragraph>(std::move(text));}) == 1);
+    CHECK(Allocations([](std::string text, std::string url) {Get<Link>(std::move(url), std::move(text));}) == 1);
+
+    // An image also builds its style value and stores its third attribute outside the node.
+    CHECK(Allocations([](std::string text, std::string url) {Get<Image>(std::move(url), std::move(text), 640, 480);}) == 3);
+
+    // The first attributes are stored in the node, so their values are moved in without allocating.
+    auto    div = Get<Div>();
+    CHECK(Allocations([&](std::string text, std::string url)
+    {
+        div->AppendAttribute("class", std::move(text));
+        div->AppendAttribute("title", std::move(url));
+    }) == 0);
+
+    // Appending children costs the node and, amortized, part of the children vector.
+    auto    body = Get<Body>();
+    std::size_t before = allocation_count;
+    for (int i = 0; i < 1000; ++i)
+    {
+        std::string text = long_text;
+
+        before += 1;    // the copy above
+        body->AppendChild(Get<Paragraph>(std::move(text)));
+    }
+    CHECK(allocation_count - before <= 1000 + 20);
+
+    return Result();
+}
@@ -0,0 +1,111 @@
+//----------------------------------------------------------------------------
+// GetCached(): same output as Get() after changes, and memory that does not
+// grow with the depth of the tree.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "allocation.h"
+#include "check.h"
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+void    TestChanges()
+{
+    Document    doc;
+    auto        body = doc.AppendChild(Get<Body>());
+    auto        table = body->AppendChild(Get<Table>());
+    auto        first = table->AppendChild(Get<TableRow>());
+    auto        second = table->AppendChild(Get<TableRow>());
+
+    first->AppendChild(Get<TableElement>("a"));
+    second->AppendChild(Get<TableElement>("b"));
+
+    CHECK(doc.GetCached() == doc.Get());
+    CHECK(doc.GetCached() == doc.Get());
+
+    second->AppendChild(Get<TableElement>("c"));
+    CHECK(doc.GetCached() == doc.Get());
+
+    first->AppendAttribute("class", "odd");
+    CHECK(doc.GetCached(Layout::Minified()) == doc.Get(Layout::Minified()));
+    CHECK(doc.GetCached(2) == doc.Get(2));
+
+    // A subtree rendered on its own, then again as part of the document.
+    CHECK(table->GetCached() == table->Get());
+    body->AppendChild(Get<Paragraph>("after"));
+    CHECK(doc.GetCached() == doc.Get());
+    CHECK(table->GetCached() == table->Get());
+
+    // A child shared with another parent is written but never cached.
+    auto    shared = Get<Div>();
+    shared->AppendChild(Get<Span>("x"));
+    body->AppendChild(shared);
+    table->AppendChild(shared);
+    CHECK(doc.GetCached() == doc.Get());
+    shared->AppendChild(Get<Span>("y"));
+    CHECK(doc.GetCached() == doc.Get());
+}
+
+//----------------------------------------------------------------------------
+void    TestRepeatedChild()
+{
+    // The same subtree twice under one parent, with a sibling between.
+    auto    x = Get<Div>();
+    auto    shared = Get<Div>();
+
+    shared->AppendChild(Get<Paragraph>("p"));
+    x->AppendChild(shared);
+    x->AppendChild(Get<Span>("between"));
+    x->AppendChild(shared);
+
+    CHECK(x->GetCached() == x->Get());
+    x->AppendClass("a-long-class-name-that-moves-everything-after-it");
+    CHECK(x->GetCached() == x->Get());
+    CHECK(x->GetCached() == x->Get());
+
+    shared->AppendChild(Get<Paragraph>("q"));
+    CHECK(x->GetCached() == x->Get());
+    CHECK(x->GetCached(Layout::Minified()) == x->Get(Layout::Minified()));
+}
+
+//----------------------------------------------------------------------------
+void    TestDeepChain()
+{
+    const std::size_t   depth = 20000;
+    auto                root = Get<Div>();
+    std::shared_ptr<NodeBase>   last = root;
+
+    for (std::size_t i = 0; i < depth; ++i)
+    {
+        last = last->AppendChild(Get<Div>());
+    }
+    last->AppendChild(Get<Span>("leaf"));
+
+    std::string expected = root->Get(Layout::Minified());
+    std::size_t before = ResetPeak();
+    std::string output = root->GetCached(Layout::Minified());
+    std::size_t used = peak_bytes_in_use - before;
+
+    CHECK(output == expected);
+    // The returned string, the kept copy and the traversal stacks.
+    CHECK(used < 8 * output.size() + 128 * depth);
+
+    last->AppendChild(Get<Span>("more"));
+    expected = root->Get(Layout::Minified());
+    before = ResetPeak();
+    output = root->GetCached(Layout::Minified());
+    used = peak_bytes_in_use - before;
+
+    CHECK(output == expected);
+    CHECK(used < 8 * output.size() + 128 * depth);
+}
+
+int main()
+{
+    TestChanges();
+    TestRepeatedChild();
+    TestDeepChain();
+
+    return Result();
+}
@@ -0,0 +1,38 @@
+//----------------------------------------------------------------------------
+// Minimal checks for the tests in this directory: CHECK(condition) reports a
+// failure with its location and Result() gives the exit code for main().
+//----------------------------------------------------------------------------
+#ifndef SIMPLE_HTML_TESTS_CHECK_H
+#define SIMPLE_HTML_TESTS_CHECK_H
+
+#include <iostream>
+
+inline  int&    Failures()
+{
+    static int  failures = 0;
+    return failures;
+}
+
+inline  bool    Check(bool condition, const char *text, const char *file, int line)
+{
+    if (!condition)
+    {
+        ++Failures();
+        std::cerr << file << ":" << line << ": CHECK(" << text << ") failed" << std::endl;
+    }
+    return condition;
+}
+
+#define CHECK(condition)    Check((condition), #condition, __FILE__, __LINE__)
+
+inline  int     Result()
+{
+    if (Failures() != 0)
+    {
+        std::cerr << Failures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+#endif  // SIMPLE_HTML_TESTS_CHECK_H
@@ -0,0 +1,84 @@
+//----------------------------------------------------------------------------
+// DeflateSink: the compressed stream inflates to the output of Get(), also
+// when the sink is destroyed without Finish().
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+using namespace simple_html;
+
+#ifdef SIMPLE_HTML_WITH_ZLIB
+/// Inflates a gzip or zlib stream; empty if it is corrupt or incomplete.
+std::string Inflate(const std::string &compressed)
+{
+    z_stream    stream{};
+    std::string result;
+    char        buffer[16 * 1024];
+
+    if (::inflateInit2(&stream, 15 + 32) != Z_OK)
+    {
+        return result;
+    }
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    stream.avail_in = uInt(compressed.size());
+
+    int status;
+    do
+    {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = uInt(sizeof(buffer));
+        status = ::inflate(&stream, Z_NO_FLUSH);
+        result.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    while (status == Z_OK);
+
+    ::inflateEnd(&stream);
+
+    return status == Z_STREAM_END ? result : std::string();
+}
+
+/// Compresses doc, calling Finish() if finish is set and leaving it to the destructor otherwise.
+std::string Compress(NodeBase &doc, const DeflateOptions &options, bool finish)
+{
+    std::string compressed;
+    {
+        StringSink  target(compressed);
+        DeflateSink deflate(target, options);
+
+        doc.Write(deflate);
+        if (finish)
+        {
+            deflate.Finish();
+        }
+    }
+    return compressed;
+}
+#endif
+
+//----------------------------------------------------------------------------
+int main()
+{
+#ifdef SIMPLE_HTML_WITH_ZLIB
+    auto    doc = Get<Document>();
+    auto    body = doc->AppendChild(Get<Body>());
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        body->AppendChild(Get<Paragraph>("paragraph " + std::to_string(i)));
+    }
+
+    const std::string   html = doc->Get();
+    DeflateOptions      zlib;
+    zlib.format = DeflateOptions::Zlib;
+
+    for (bool finish : {true, false})
+    {
+        CHECK(Inflate(Compress(*doc, DeflateOptions(), finish)) == html);
+        CHECK(Inflate(Compress(*doc, zlib, finish)) == html);
+    }
+#endif
+
+    return Result();
+}
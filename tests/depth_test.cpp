@@ -0,0 +1,94 @@
+//----------------------------------------------------------------------------
+// Deep trees: a chain of 100000 nodes is written, measured, cached and
+// destroyed without recursion.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+using namespace simple_html;
+
+const std::size_t   depth = 100000;
+
+//----------------------------------------------------------------------------
+/// A chain of depth nodes of type T ending in a text leaf; last is set to the innermost node.
+template<typename T>
+std::shared_ptr<NodeBase>   Chain(std::shared_ptr<NodeBase> &last)
+{
+    std::shared_ptr<NodeBase>   root = Get<T>();
+
+    last = root;
+    for (std::size_t i = 1; i < depth; ++i)
+    {
+        last = last->AppendChild(Get<T>());
+    }
+    last->AppendChild(Get<Text>("leaf & more"));
+
+    return root;
+}
+
+//----------------------------------------------------------------------------
+std::string Repeat(const std::string &text, std::size_t count)
+{
+    std::string result;
+    result.reserve(text.size() * count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        result += text;
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------
+/// Block elements, minified: the default layout would indent every level.
+void    TestBlockChain()
+{
+    std::shared_ptr<NodeBase>   last;
+    auto                        root = Chain<Div>(last);
+    const Layout                layout = Layout::Minified();
+    const std::string           expected = Repeat("<div>", depth) + "leaf &amp; more" + Repeat("</div>", depth);
+
+    CHECK(root->Get(layout) == expected);
+    CHECK(root->SerializedSize(layout) == expected.size());
+    CHECK(root->GetPresized(0, layout) == expected);
+    CHECK(root->GetCached(layout) == expected);
+
+    // Reused, then changed at the bottom.
+    CHECK(root->GetCached(layout) == expected);
+    last->AppendChild(Get<Span>("end"));
+    const std::string   changed = Repeat("<div>", depth) + "leaf &amp; more<span>end</span>" + Repeat("</div>", depth);
+    CHECK(root->GetCached(layout) == changed);
+    CHECK(root->SerializedSize(layout) == changed.size());
+
+    last.reset();
+    root.reset();
+}
+
+//----------------------------------------------------------------------------
+/// Inline elements in the default layout.
+void    TestInlineChain()
+{
+    std::shared_ptr<NodeBase>   last;
+    auto                        root = Chain<Span>(last);
+    const std::string           expected = Repeat("<span>", depth) + "leaf &amp; more" + Repeat("</span>", depth);
+
+    CHECK(root->Get() == expected);
+    CHECK(root->SerializedSize() == expected.size());
+    CHECK(root->GetCached() == expected);
+    CHECK(root->GetCached() == expected);
+
+    // The chain above the leaf goes first; the leaf is still usable.
+    root.reset();
+    CHECK(last->Get() == "<span>leaf &amp; more</span>");
+    CHECK(last->GetCached() == "<span>leaf &amp; more</span>");
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    TestBlockChain();
+    TestInlineChain();
+
+    return Result();
+}
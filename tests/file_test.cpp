@@ -0,0 +1,137 @@
+//----------------------------------------------------------------------------
+// FileSink and Document::WriteToFile(): the file holds exactly what Get()
+// returns, for every write method and buffer size.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+std::string TempPath(const char *name)
+{
+    const char  *directory = std::getenv("TMPDIR");
+
+    return std::string(directory != nullptr ? directory : "/tmp") + "/simple_html_" + name + "_" + std::to_string(::getpid()) + ".html";
+}
+
+//----------------------------------------------------------------------------
+std::string ReadFile(const std::string &path)
+{
+    std::ifstream       file(path, std::ios::binary);
+    std::ostringstream  contents;
+
+    contents << file.rdbuf();
+
+    return contents.str();
+}
+
+//----------------------------------------------------------------------------
+/// A document of rows paragraphs with escaped text.
+std::shared_ptr<Document>   Sample(int rows)
+{
+    auto    doc = Get<Document>();
+    doc->AppendChild(Get<Head>())->AppendChild(Get<Title>("File & test"));
+
+    auto    body = doc->AppendChild(Get<Body>());
+    for (int i = 0; i < rows; ++i)
+    {
+        body->AppendChild(Get<Paragraph>("paragraph " + std::to_string(i) + " <&>"));
+    }
+
+    return doc;
+}
+
+//----------------------------------------------------------------------------
+void    TestFileSink()
+{
+    const std::string   path = TempPath("sink");
+
+    for (int rows : {0, 10, 20000})
+    {
+        auto    doc = Sample(rows);
+
+        // The smallest buffer writes many times, the default one once.
+        for (std::size_t buffer_size : {std::size_t(1), FileOptions().buffer_size})
+        {
+            FileOptions options;
+            options.buffer_size = buffer_size;
+            options.layout = Layout::Minified();
+
+            FileSink    sink(path, options);
+            doc->Write(sink);
+            CHECK(sink.Close() == doc->Get(Layout::Minified()).size());
+            CHECK(ReadFile(path) == doc->Get(Layout::Minified()));
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+//----------------------------------------------------------------------------
+void    TestWriteToFile()
+{
+    const std::string   path = TempPath("document");
+    auto                doc = Sample(5000);
+
+    for (auto method : {FileOptions::Buffered, FileOptions::Mapped})
+    {
+        for (auto sync : {FileOptions::NoSync, FileOptions::DataSync, FileOptions::FullSync})
+        {
+            for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+            {
+                FileOptions options;
+                options.method = method;
+                options.sync = sync;
+                options.layout = layout;
+
+                CHECK(doc->WriteToFile(path, options) == doc->Get(layout).size());
+                CHECK(ReadFile(path) == doc->Get(layout));
+            }
+        }
+    }
+
+    // O_DIRECT, or the page cache where the file system does not support it.
+    FileOptions options;
+    options.direct = true;
+    options.buffer_size = 4096;
+    CHECK(doc->WriteToFile(path, options) == doc->Get().size());
+    CHECK(ReadFile(path) == doc->Get());
+
+    // A shorter document truncates the file.
+    auto    empty = Get<Document>();
+    CHECK(empty->WriteToFile(path) == empty->Get().size());
+    CHECK(ReadFile(path) == empty->Get());
+
+    std::remove(path.c_str());
+}
+
+//----------------------------------------------------------------------------
+void    TestFailure()
+{
+    bool    threw = false;
+    try
+    {
+        Get<Document>()->WriteToFile("/nonexistent/directory/file.html");
+    }
+    catch (const std::system_error&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    TestFileSink();
+    TestWriteToFile();
+    TestFailure();
+
+    return Result();
+}
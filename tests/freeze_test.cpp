@@ -0,0 +1,175 @@
+//----------------------------------------------------------------------------
+// Freeze(): frozen subtrees are immutable, render like unfrozen ones, can be
+// shared between parents and threads, and outlive the parents they were
+// built under.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+#include <stdexcept>
+#include <thread>
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/// A small subtree with block and inline children, attributes and escaped text.
+std::shared_ptr<NodeBase>   Sample()
+{
+    auto    div = Get<Div>();
+    div->AppendId("sample").AppendClass("box");
+
+    auto    list = div->AppendChild(Get<UnorderedList>());
+    list->AppendChild(Get<ListItem>("one"));
+    list->AppendChild(Get<ListItem>("two & three"));
+
+    auto    p = div->AppendChild(Get<Paragraph>("text <with> markup"));
+    p->AppendChild(Get<Span>("inline"));
+    p->AppendChild(Get<Link>("https://example.com/?a=1&b=2", "link"));
+
+    return div;
+}
+
+//----------------------------------------------------------------------------
+/// Mutating a frozen node, or a node below it, throws std::logic_error.
+void    TestMutationThrows()
+{
+    auto    div = Get<Div>();
+    auto    p = div->AppendChild(Get<Paragraph>("text"));
+    div->Freeze();
+
+    CHECK(div->is_frozen());
+    CHECK(p->is_frozen());
+
+    const std::string   before = div->Get();
+
+    bool    threw = false;
+    try {div->AppendChild(Get<Span>());} catch (const std::logic_error&) {threw = true;}
+    CHECK(threw);
+
+    threw = false;
+    try {p->SetValue("other");} catch (const std::logic_error&) {threw = true;}
+    CHECK(threw);
+
+    threw = false;
+    try {p->AppendClass("other");} catch (const std::logic_error&) {threw = true;}
+    CHECK(threw);
+
+    CHECK(div->Get() == before);
+}
+
+//----------------------------------------------------------------------------
+/// Frozen output equals the output of the same tree unfrozen, both within and
+/// beyond the indentation levels kept by Freeze().
+void    TestOutputUnchanged()
+{
+    auto    frozen = Sample();
+    auto    plain = Sample();
+    frozen->Freeze();
+
+    for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+    {
+        for (int indentation : {0, 1, 3, 15, 16, 20})
+        {
+            // Twice, to compare the rendered and the reused output.
+            CHECK(frozen->Get(layout, indentation) == plain->Get(layout, indentation));
+            CHECK(frozen->Get(layout, indentation) == plain->Get(layout, indentation));
+        }
+    }
+
+    // Written under parents at different depths.
+    auto    page = Get<Div>();
+    page->AppendChild(Get<Div>())->AppendChild(frozen);
+    page->AppendChild(frozen);
+
+    auto    expected = Get<Div>();
+    expected->AppendChild(Get<Div>())->AppendChild(Sample());
+    expected->AppendChild(Sample());
+
+    CHECK(page->Get() == expected->Get());
+    CHECK(page->Get(Layout::Minified()) == expected->Get(Layout::Minified()));
+    CHECK(page->GetCached() == expected->Get());
+}
+
+//----------------------------------------------------------------------------
+/// A frozen subtree shared by two parents is written from several threads at once.
+void    TestSharedAcrossThreads()
+{
+    auto    shared = Sample();
+    shared->Freeze();
+
+    auto    first = Get<Div>();
+    first->AppendChild(shared);
+
+    auto    second = Get<Body>();
+    second->AppendChild(Get<Div>())->AppendChild(shared);
+    second->AppendChild(shared);
+    first->Freeze();
+    second->Freeze();
+
+    auto    first_expected = Get<Div>();
+    first_expected->AppendChild(Sample());
+
+    auto    second_expected = Get<Body>();
+    second_expected->AppendChild(Get<Div>())->AppendChild(Sample());
+    second_expected->AppendChild(Sample());
+
+    const std::string   expected[] = {first_expected->Get(), second_expected->Get(), first_expected->Get(Layout::Minified()), second_expected->Get(Layout::Minified())};
+
+    std::atomic<int>            mismatches{0};
+    std::vector<std::thread>    threads;
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back([&, t]
+        {
+            for (int i = 0; i < 200; ++i)
+            {
+                const bool  minified = (i + t) % 2 != 0;
+                const Layout    layout = minified ? Layout::Minified() : Layout();
+                if (first->Get(layout) != expected[minified ? 2 : 0])   ++mismatches;
+                if (second->Get(layout) != expected[minified ? 3 : 1])  ++mismatches;
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(mismatches == 0);
+}
+
+//----------------------------------------------------------------------------
+/// A node frozen under one parent is written under another after the first is gone.
+void    TestFirstParentGone()
+{
+    auto    slot = Get<Slot>("content");
+    {
+        auto    a = Get<Div>();
+        a->AppendChild(slot);
+        slot->Freeze();
+    }
+
+    auto    b = Get<Div>();
+    b->AppendChild(Get<Paragraph>("before"));
+    b->AppendChild(slot);
+
+    auto    expected = Get<Div>();
+    expected->AppendChild(Get<Paragraph>("before"));
+    expected->AppendChild(Get<Text>("text"));
+
+    const Template  page(*b);
+    CHECK(page.Render(TemplateValues().Set("content", "text")) == expected->Get());
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    TestMutationThrows();
+    TestOutputUnchanged();
+    TestSharedAcrossThreads();
+    TestFirstParentGone();
+
+    return Result();
+}
@@ -0,0 +1,149 @@
+//----------------------------------------------------------------------------
+// Hash() and ETag(): equal for structurally equal trees, changed by every
+// change that changes the output.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+#include <set>
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/// A small tree, keeping the nodes the tests change.
+class   Sample
+{
+public:
+    std::shared_ptr<NodeBase>   root{Get<Div>()};
+    std::shared_ptr<NodeBase>   list;
+    std::shared_ptr<NodeBase>   item;
+
+    Sample()
+    {
+        root->AppendClass("box");
+        root->AppendChild(Get<Heading>("Title", 2));
+        list = root->AppendChild(Get<UnorderedList>());
+        item = list->AppendChild(Get<ListItem>("one"));
+        list->AppendChild(Get<ListItem>("two"))->AppendAttribute("data-n", 2);
+        root->AppendChild(Get<Paragraph>("text & more"));
+    }
+};
+
+//----------------------------------------------------------------------------
+void    TestEqualTrees()
+{
+    Sample  a;
+    Sample  b;
+
+    CHECK(a.root->Hash() == b.root->Hash());
+    CHECK(a.root->ETag() == b.root->ETag());
+    CHECK(a.item->Hash() == b.item->Hash());
+
+    // Cached hashes agree with fresh ones.
+    CHECK(a.root->Hash() == Sample().root->Hash());
+
+    // Different layouts give different tags for the same tree.
+    CHECK(a.root->ETag() != a.root->ETag(Layout::Minified()));
+    CHECK(a.root->ETag(Layout::Spaces(2)) == b.root->ETag(Layout::Spaces(2)));
+    CHECK(a.root->ETag().size() == 18);
+    CHECK(a.root->ETag().front() == '"' && a.root->ETag().back() == '"');
+
+    // The same bytes from another class hash differently.
+    CHECK(Get<Div>()->Hash() != Get<Element<tags::div>>()->Hash());
+    CHECK(Get<Div>()->Hash() != Get<Span>()->Hash());
+}
+
+//----------------------------------------------------------------------------
+/// Every change below the root, through the mutators that Touch() the node, reaches the root's hash.
+void    TestChanges()
+{
+    Sample                  sample;
+    std::set<std::uint64_t> seen{sample.root->Hash()};
+    std::set<std::string>   tags{sample.root->ETag()};
+
+    auto    changed = [&]()
+    {
+        bool    fresh = seen.insert(sample.root->Hash()).second;
+        tags.insert(sample.root->ETag());
+        return fresh;
+    };
+
+    sample.item->SetValue("uno");
+    CHECK(changed());
+
+    sample.item->AppendClass("first");
+    CHECK(changed());
+
+    sample.item->AppendAttribute("data-n", 1);
+    CHECK(changed());
+
+    sample.list->AppendChild(Get<ListItem>("three"));
+    CHECK(changed());
+
+    sample.root->AppendId("main");
+    CHECK(changed());
+
+    // Touched, but written the same: the hash is computed again and equal.
+    sample.item->SetValue("uno");
+    CHECK(!changed());
+    CHECK(tags.size() == seen.size());
+
+    // Hashes depend on content, not on history: the same tree built directly.
+    Sample  rebuilt;
+    rebuilt.item->SetValue("uno");
+    rebuilt.item->AppendClass("first");
+    rebuilt.item->AppendAttribute("data-n", 1);
+    rebuilt.list->AppendChild(Get<ListItem>("three"));
+    rebuilt.root->AppendId("main");
+    CHECK(rebuilt.root->Hash() == sample.root->Hash());
+    CHECK(rebuilt.root->ETag() == sample.root->ETag());
+}
+
+//----------------------------------------------------------------------------
+/// A child shared by two parents is not cached, so its changes still show.
+void    TestSharedChild()
+{
+    auto    shared = Get<Paragraph>("shared");
+    auto    a = Get<Div>();
+    auto    b = Get<Div>();
+    a->AppendChild(shared);
+    b->AppendChild(shared);
+
+    std::uint64_t   before = b->Hash();
+    CHECK(a->Hash() == before);
+
+    shared->SetValue("changed");
+    CHECK(a->Hash() != before);
+    CHECK(b->Hash() != before);
+    CHECK(a->Hash() == b->Hash());
+}
+
+//----------------------------------------------------------------------------
+/// Frozen subtrees keep the hash they had when frozen.
+void    TestFrozen()
+{
+    Sample  frozen;
+    Sample  plain;
+    frozen.root->Freeze();
+
+    CHECK(frozen.root->Hash() == plain.root->Hash());
+
+    auto    page = Get<Body>();
+    page->AppendChild(frozen.root);
+    auto    expected = Get<Body>();
+    expected->AppendChild(plain.root);
+    CHECK(page->Hash() == expected->Hash());
+    CHECK(page->ETag() == expected->ETag());
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    TestEqualTrees();
+    TestChanges();
+    TestSharedChild();
+    TestFrozen();
+
+    return Result();
+}
@@ -0,0 +1,52 @@
+//----------------------------------------------------------------------------
+// Document::FindById() and FindByClass() for attributes of every kind, added
+// before and after the node is appended to the document; template slots are
+// left out.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+int main()
+{
+    Document    doc;
+    auto        body = doc.AppendChild(Get<Body>());
+
+    // Attributes added to a node already in the document.
+    auto    text = body->AppendChild(Get<Div>());
+    auto    integer = body->AppendChild(Get<Div>());
+    auto    number = body->AppendChild(Get<Div>());
+
+    text->AppendAttribute("id", "intro");
+    text->AppendAttribute("class", "a b");
+    integer->AppendAttribute("id", 7);
+    number->AppendAttribute("id", 2.5);
+
+    CHECK(doc.FindById("intro") == text.get());
+    CHECK(doc.FindById("7") == integer.get());
+    CHECK(doc.FindById("2.5") == number.get());
+    CHECK(doc.FindByClass("b").size() == 1 && doc.FindByClass("b")[0] == text.get());
+
+    // Attributes added before the node is appended.
+    auto    later = Get<Div>();
+    later->AppendAttribute("id", 0.25, NumberFormat{3});
+    body->AppendChild(later);
+
+    CHECK(doc.FindById("0.250") == later.get());
+    CHECK(doc.DuplicateIds().empty());
+
+    // Slots are not indexed under their slot names.
+    auto    slotted = Get<Div>();
+    slotted->AppendAttributeSlot("id", "intro");
+    slotted->AppendAttributeSlot("class", "a");
+    body->AppendChild(slotted);
+
+    CHECK(doc.FindById("intro") == text.get());
+    CHECK(doc.FindByClass("a").size() == 1);
+    CHECK(doc.DuplicateIds().empty());
+
+    return Result();
+}
@@ -0,0 +1,67 @@
+//----------------------------------------------------------------------------
+// NodeInterner: equal subtrees share one node, except where an id or content
+// of its own sits anywhere in the subtree; those are neither shared nor frozen.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/// A row of two cells; the second gets id if it is not empty.
+std::shared_ptr<TableRow>   Row(NodeInterner &cells, const std::string &id)
+{
+    auto    row = Get<TableRow>();
+    auto    cell = Get<TableElement>("OK");
+
+    row->AppendChild(cells.Get<TableElement>("1"));
+    if (!id.empty())
+    {
+        cell->AppendId(id);
+    }
+    row->AppendChild(cells.Intern(cell));
+
+    return row;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    NodeInterner    interner;
+
+    // Rows without ids are shared whole.
+    auto    first = interner.Intern(Row(interner, ""));
+    auto    second = interner.Intern(Row(interner, ""));
+    CHECK(first == second);
+
+    // A cell with an id keeps the row it is in unshared, and the page keeps both ids.
+    Document    doc;
+    auto        table = doc.AppendChild(Get<Body>())->AppendChild(Get<Table>());
+    auto        a = interner.Intern(Row(interner, "a"));
+    auto        b = interner.Intern(Row(interner, "b"));
+    auto        again = interner.Intern(Row(interner, "a"));
+
+    CHECK(a != again);
+    CHECK(!a->is_frozen() && first->is_frozen());
+    table->AppendChild(a);
+    table->AppendChild(b);
+    CHECK(doc.FindById("a") != nullptr && doc.FindById("b") != nullptr);
+    CHECK(doc.FindById("a") != doc.FindById("b"));
+    CHECK(doc.DuplicateIds().empty());
+
+    // Unfrozen, the row can still change and the index follows.
+    a->AppendChild(Get<TableElement>("late"))->AppendAttribute("id", "late");
+    CHECK(doc.FindById("late") != nullptr);
+
+    // The output does not change.
+    auto    plain = Get<Table>();
+    plain->AppendChild(Row(interner, ""));
+    plain->AppendChild(Row(interner, "c"));
+    auto    shared = Get<Table>();
+    shared->AppendChild(interner.Intern(Row(interner, "")));
+    shared->AppendChild(interner.Intern(Row(interner, "c")));
+    CHECK(plain->Get() == shared->Get());
+
+    return Result();
+}
@@ -0,0 +1,106 @@
+//----------------------------------------------------------------------------
+// GetParallel(): output identical to Get() when wide nodes are written from
+// several threads.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/// A rows x columns table with escaped text, attributes, inline children and
+/// a frozen row shared by every tenth position.
+std::shared_ptr<NodeBase>   WideTable(int rows, int columns)
+{
+    auto    shared = Get<TableRow>();
+    shared->AppendChild(Get<TableElement>("shared <row>"));
+    shared->Freeze();
+
+    auto    table = Get<Table>();
+    for (int r = 0; r < rows; ++r)
+    {
+        if (r % 10 == 9)
+        {
+            table->AppendChild(shared);
+            continue;
+        }
+
+        auto    row = table->AppendChild(Get<TableRow>());
+        row->AppendClass(r % 2 == 0 ? "even" : "odd");
+        for (int c = 0; c < columns; ++c)
+        {
+            auto    cell = row->AppendChild(Get<TableElement>(std::to_string(r) + " & " + std::to_string(c)));
+            if (c == 0)
+            {
+                cell->AppendChild(Get<Span>("first"));
+            }
+        }
+    }
+
+    auto    div = Get<Div>();
+    div->AppendChild(Get<Paragraph>("before"));
+    div->AppendChild(table);
+    div->AppendChild(Get<Paragraph>("after"));
+
+    return div;
+}
+
+//----------------------------------------------------------------------------
+void    TestWideTable()
+{
+    auto    div = WideTable(500, 5);
+
+    for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+    {
+        for (int indentation : {0, 2})
+        {
+            const std::string   expected = div->Get(layout, indentation);
+
+            for (unsigned threads : {1u, 2u, 3u, 8u})
+            {
+                ParallelOptions options;
+                options.threads = threads;
+                options.threshold = 2;
+
+                CHECK(div->GetParallel(layout, options, indentation) == expected);
+
+                // Only the table is wide enough.
+                options.threshold = 100;
+                CHECK(div->GetParallel(layout, options, indentation) == expected);
+            }
+        }
+    }
+
+    ParallelOptions options;
+    options.threads = 4;
+    options.threshold = 2;
+    CHECK(div->GetParallel(options) == div->Get());
+}
+
+//----------------------------------------------------------------------------
+/// Fewer children than threads, and nodes that render their children themselves.
+void    TestNarrow()
+{
+    ParallelOptions options;
+    options.threads = 8;
+    options.threshold = 2;
+
+    auto    list = Get<UnorderedList>();
+    list->AppendChild(Get<ListItem>("one"));
+    list->AppendChild(Get<ListItem>("two"));
+    CHECK(list->GetParallel(Layout::Minified(), options) == list->Get(Layout::Minified()));
+    CHECK(list->GetParallel(options, 1) == list->Get(1));
+
+    auto    empty = Get<Div>();
+    CHECK(empty->GetParallel(options) == empty->Get());
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    TestWideTable();
+    TestNarrow();
+
+    return Result();
+}
@@ -0,0 +1,92 @@
+//----------------------------------------------------------------------------
+// ParseHtml() on the library's own output: parsing Get() in the layout it was
+// written in and writing the result again gives the same text, whitespace in
+// values and texts included. Tag and attribute names the library does not know
+// live with the parsed nodes rather than in the global name pools.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/// A page with whitespace at both ends of values and texts, in block, line and inline nodes.
+std::shared_ptr<Document>   Page()
+{
+    auto    doc = Get<Document>();
+    auto    body = doc->AppendChild(Get<Body>());
+    auto    div = body->AppendChild(Get<Div>());
+
+    div->AppendChild(Get<Paragraph>(" t "));
+    div->AppendChild(Get<Paragraph>("\n\tindented\n"));
+    div->AppendChild(Get<Heading>("  heading  ", 1));
+
+    auto    paragraph = div->AppendChild(Get<Paragraph>("value "));
+    paragraph->AppendChild(Get<Text>(" t "));
+    paragraph->AppendChild(Get<Span>(" span "));
+    paragraph->AppendChild(Get<Text>(" "));
+    paragraph->AppendChild(Get<Link>("https://example.com", " link "));
+    paragraph->AppendChild(Get<Text>("\n"));
+
+    auto    list = body->AppendChild(Get<UnorderedList>());
+    list->AppendChild(Get<ListItem>(" one "));
+    list->AppendChild(Get<ListItem>("two\n"));
+
+    auto    table = body->AppendChild(Get<Table>());
+    auto    row = table->AppendChild(Get<TableRow>());
+    row->AppendChild(Get<TableElement>(" 1 "));
+    row->AppendChild(Get<TableElement>("\t2"));
+
+    body->AppendChild(Get<Text>(" trailing "));
+
+    return doc;
+}
+
+/// Parses html written in layout and writes the result again in the same layout.
+std::string RoundTrip(const std::string &html, const Layout &layout)
+{
+    std::string result;
+
+    for (const auto &node : ParseHtml(html, layout))
+    {
+        result += node->Get(layout);
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    auto    page = Page();
+
+    for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+    {
+        const std::string   html = page->Get(layout);
+
+        CHECK(RoundTrip(html, layout) == html);
+    }
+
+    // Whitespace that is not the layout is kept in front of a child and an end tag.
+    CHECK(RoundTrip("<div> <p>x</p> </div>", Layout::Minified()) == "<div> <p>x</p> </div>");
+    CHECK(RoundTrip("<p> t </p>", Layout::Minified()) == "<p> t </p>");
+
+    // Unknown names round-trip and stay valid in the nodes after the parser is gone.
+    const std::string   custom = "<x-card data-state=\"open\"><x-title data-level=\"1\">t</x-title></x-card>";
+    auto    cards = ParseHtml(custom, Layout::Minified());
+
+    CHECK(cards.size() == 1 && cards[0]->Get(Layout::Minified()) == custom);
+    CHECK(&cards[0]->Tag() != &InternTagName("x-card"));
+
+    auto    holder = Get<Div>();
+    HtmlParser(Layout::Minified()).ParseInto(*holder, custom);
+    CHECK(holder->Get(Layout::Minified()) == "<div>" + custom + "</div>");
+
+    // A built tree with the same names is equal to the parsed one, attribute by attribute.
+    auto    built = Get<Div>();
+    built->AppendAttribute("data-state", "open");
+    auto    parsed = ParseHtml("<div data-state=\"open\"></div>", Layout::Minified());
+    CHECK(Patch(*parsed.at(0), *built).empty());
+
+    return Result();
+}
@@ -0,0 +1,554 @@
+//----------------------------------------------------------------------------
+// Patch: the JSON edit script applied the way a browser client applies it, to
+// a DOM parsed from the output of the old tree, gives the DOM of the new one.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include <map>
+#include <random>
+
+#include "check.h"
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The Dom class is the little of a browser DOM the client needs: elements
+ * with attributes, and text nodes.
+ */
+class   Dom
+{
+public:
+    std::string                                         tag;    ///< Empty for a text node.
+    std::string                                         text;
+    std::vector<std::pair<std::string, std::string>>    attributes;
+    std::vector<std::shared_ptr<Dom>>                   children;
+
+    bool    IsText() const {return tag.empty();}
+
+    /// Element.children.
+    std::vector<std::shared_ptr<Dom>>   Elements() const
+    {
+        std::vector<std::shared_ptr<Dom>>   elements;
+
+        for (auto &c : children)
+        {
+            if (!c->IsText())
+            {
+                elements.push_back(c);
+            }
+        }
+        return elements;
+    }
+
+    std::string*    Attribute(const std::string &name)
+    {
+        for (auto &a : attributes)
+        {
+            if (a.first == name)
+            {
+                return &a.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+/// Parses HTML as written by simple_html into DOM nodes; repeated attributes keep the first.
+std::vector<std::shared_ptr<Dom>>   ParseDom(const std::string &html)
+{
+    static const char   *voids[] = {"br", "img", "hr", "meta", "link", "input", "area", "base", "col", "embed", "source", "track", "wbr"};
+
+    Dom                 top;
+    std::vector<Dom*>   open{&top};
+    std::size_t         i = 0;
+
+    while (i < html.size())
+    {
+        if (html.compare(i, 2, "<!") == 0)
+        {
+            i = html.find('>', i) + 1;
+        }
+        else if (html.compare(i, 2, "</") == 0)
+        {
+            std::size_t end = html.find('>', i);
+            std::string name = html.substr(i + 2, end - i - 2);
+
+            while (open.size() > 1 && open.back()->tag != name)
+            {
+                open.pop_back();
+            }
+            if (open.size() > 1)
+            {
+                open.pop_back();
+            }
+            i = end + 1;
+        }
+        else if (html[i] == '<')
+        {
+            auto        element = std::make_shared<Dom>();
+            std::size_t name_end = html.find_first_of(" >", i);
+
+            element->tag = html.substr(i + 1, name_end - i - 1);
+            i = name_end;
+            while (html[i] == ' ')
+            {
+                std::size_t equals = html.find('=', i);
+                std::size_t close = html.find('"', equals + 2);
+                std::string name = html.substr(i + 1, equals - i - 1);
+                std::string value;
+
+                AppendUnescaped(value, std::string_view(html).substr(equals + 2, close - equals - 2));
+                if (element->Attribute(name) == nullptr)
+                {
+                    element->attributes.push_back({name, value});
+                }
+                i = close + 1;
+            }
+            i += 1;
+
+            open.back()->children.push_back(element);
+            if (std::find_if(std::begin(voids), std::end(voids), [&](const char *v) {return element->tag == v;}) == std::end(voids))
+            {
+                open.push_back(element.get());
+            }
+        }
+        else
+        {
+            std::size_t end = std::min(html.find('<', i), html.size());
+            auto        &siblings = open.back()->children;
+
+            if (siblings.empty() || !siblings.back()->IsText())
+            {
+                siblings.push_back(std::make_shared<Dom>());
+            }
+            AppendUnescaped(siblings.back()->text, std::string_view(html).substr(i, end - i));
+            i = end;
+        }
+    }
+
+    return top.children;
+}
+
+/// The text with the layout whitespace at both ends left out.
+std::string Trimmed(const std::string &text)
+{
+    std::size_t first = text.find_first_not_of(" \t\n");
+    std::size_t last = text.find_last_not_of(" \t\n");
+
+    return first == std::string::npos ? "" : text.substr(first, last - first + 1);
+}
+
+/// The DOM as text, with adjacent text nodes joined and layout whitespace left out.
+std::string Canonical(const Dom &node)
+{
+    std::map<std::string, std::string>  attributes(node.attributes.begin(), node.attributes.end());
+    std::string                         result = "<" + node.tag;
+    std::string                         text;
+
+    for (auto &a : attributes)
+    {
+        result += " " + a.first + "=" + a.second;
+    }
+    result += ">";
+    for (auto &c : node.children)
+    {
+        if (c->IsText())
+        {
+            text += Trimmed(c->text);
+            continue;
+        }
+        if (!text.empty())
+        {
+            result += "\"" + text + "\"";
+            text.clear();
+        }
+        result += Canonical(*c);
+    }
+    if (!text.empty())
+    {
+        result += "\"" + text + "\"";
+    }
+
+    return result + "</" + node.tag + ">";
+}
+
+/// The document element of a page.
+std::shared_ptr<Dom>    ParseRoot(const std::string &html)
+{
+    for (auto &node : ParseDom(html))
+    {
+        if (!node->IsText())
+        {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+Dom*    FindById(Dom &node, const std::string &id)
+{
+    std::string *value = node.Attribute("id");
+
+    if (value != nullptr && *value == id)
+    {
+        return &node;
+    }
+    for (auto &c : node.children)
+    {
+        if (Dom *found = FindById(*c, id))
+        {
+            return found;
+        }
+    }
+    return nullptr;
+}
+
+Dom*    FindParent(Dom &node, const Dom *child)
+{
+    for (auto &c : node.children)
+    {
+        if (c.get() == child)
+        {
+            return &node;
+        }
+        if (Dom *found = FindParent(*c, child))
+        {
+            return found;
+        }
+    }
+    return nullptr;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief The JsonEdit class is one object of Patch::ToJson(), read back by JsonEdits().
+ */
+class   JsonEdit
+{
+public:
+    std::string                 op;
+    std::string                 id;
+    std::vector<std::size_t>    path;
+    std::string                 name;
+    std::string                 value;
+};
+
+std::string ReadJsonString(const std::string &json, std::size_t &i)
+{
+    std::string result;
+
+    for (++i; json[i] != '"'; ++i)
+    {
+        if (json[i] != '\\')
+        {
+            result += json[i];
+            continue;
+        }
+
+        switch (json[++i])
+        {
+        case 'n':   result += '\n'; break;
+        case 'r':   result += '\r'; break;
+        case 't':   result += '\t'; break;
+        case 'u':   result += char(std::stoi(json.substr(i + 1, 4), nullptr, 16)); i += 4; break;
+        default:    result += json[i]; break;
+        }
+    }
+    ++i;
+
+    return result;
+}
+
+std::vector<JsonEdit>   JsonEdits(const std::string &json)
+{
+    std::vector<JsonEdit>   edits;
+    std::size_t             i = 1;
+
+    while (json[i] == '{')
+    {
+        JsonEdit    edit;
+
+        ++i;
+        while (json[i] != '}')
+        {
+            std::string key = ReadJsonString(json, i);
+
+            ++i;
+            if (key == "path")
+            {
+                for (++i; json[i] != ']';)
+                {
+                    std::size_t length;
+                    edit.path.push_back(std::stoul(json.substr(i), &length));
+                    i += length;
+                    i += json[i] == ',' ? 1 : 0;
+                }
+                ++i;
+            }
+            else
+            {
+                std::string value = ReadJsonString(json, i);
+
+                (key == "op" ? edit.op : key == "id" ? edit.id : key == "name" ? edit.name : edit.value) = value;
+            }
+            i += json[i] == ',' ? 1 : 0;
+        }
+        edits.push_back(edit);
+        i += json[i + 1] == ',' ? 2 : 1;
+    }
+
+    return edits;
+}
+
+/// Applies the edits like a browser client: ids through getElementById(), paths through Element.children.
+void    Apply(std::shared_ptr<Dom> &root, const std::vector<JsonEdit> &edits)
+{
+    for (auto &e : edits)
+    {
+        Dom         *node = e.id.empty() ? root.get() : FindById(*root, e.id);
+        std::size_t steps = e.path.size() - (e.op == "insert" ? 1 : 0);
+
+        if (!CHECK(node != nullptr))
+        {
+            return;
+        }
+        for (std::size_t k = 0; k < steps; ++k)
+        {
+            auto    elements = node->Elements();
+
+            if (!CHECK(e.path[k] < elements.size()))
+            {
+                return;
+            }
+            node = elements[e.path[k]].get();
+        }
+
+        if (e.op == "insert")
+        {
+            auto    elements = node->Elements();
+            auto    position = node->children.end();
+
+            if (e.path.back() < elements.size())
+            {
+                position = std::find(node->children.begin(), node->children.end(), elements[e.path.back()]);
+            }
+            auto    nodes = ParseDom(e.value);
+            node->children.insert(position, nodes.begin(), nodes.end());
+        }
+        else if (e.op == "replace" || e.op == "remove")
+        {
+            auto    nodes = e.op == "replace" ? ParseDom(e.value) : std::vector<std::shared_ptr<Dom>>();
+
+            if (node == root.get())
+            {
+                CHECK(nodes.size() == 1);
+                root = nodes.front();
+                continue;
+            }
+
+            auto    &siblings = FindParent(*root, node)->children;
+            auto    position = std::find_if(siblings.begin(), siblings.end(), [node](auto &c) {return c.get() == node;});
+
+            position = siblings.erase(position);
+            siblings.insert(position, nodes.begin(), nodes.end());
+        }
+        else if (e.op == "set_attribute")
+        {
+            if (std::string *value = node->Attribute(e.name))
+            {
+                *value = e.value;
+            }
+            else
+            {
+                node->attributes.push_back({e.name, e.value});
+            }
+        }
+        else if (e.op == "remove_attribute")
+        {
+            node->attributes.erase(std::remove_if(node->attributes.begin(), node->attributes.end(), [&e](auto &a) {return a.first == e.name;}),
+                                   node->attributes.end());
+        }
+        else if (e.op == "set_text")
+        {
+            auto    &children = node->children;
+            auto    first_element = std::find_if(children.begin(), children.end(), [](auto &c) {return !c->IsText();});
+
+            children.erase(children.begin(), first_element);
+            if (!e.value.empty())
+            {
+                auto    text = std::make_shared<Dom>();
+                text->text = e.value;
+                children.insert(children.begin(), text);
+            }
+        }
+        else
+        {
+            CHECK(false);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// A random tree; with perturb set, the same tree with random changes.
+std::shared_ptr<NodeBase>   Generate(std::mt19937 &random, std::mt19937 *perturb, int depth, int &ids)
+{
+    auto    coin = [&](unsigned percent) {return perturb != nullptr && (*perturb)() % 100 < percent;};
+    int     kind = int(random() % 6);
+
+    if (coin(3))
+    {
+        kind = (kind + 1) % 6;
+    }
+
+    std::shared_ptr<NodeBase>   node;
+    switch (kind)
+    {
+    case 0:     node = Get<Div>(); break;
+    case 1:     node = Get<NodeBase>("section", "p" + std::to_string(random() % 3)); break;
+    case 2:     node = Get<Span>("s"); break;
+    case 3:     node = Get<NodeBase>("article"); break;
+    case 4:     node = Get<Heading>("t", 2); break;
+    default:    return Get<Text>(coin(10) ? "changed" : "t" + std::to_string(random() % 3));
+    }
+
+    if (random() % 3 == 0)
+    {
+        node->AppendId("id" + std::to_string(ids++));
+    }
+    if (random() % 2 == 0)
+    {
+        node->AppendClass(coin(5) ? "changed" : "c" + std::to_string(random() % 3));
+    }
+    if (random() % 8 == 0)
+    {
+        node->AppendClass("again");
+    }
+    if (coin(5))
+    {
+        node->AppendAttribute("data-x", "1 < 2");
+    }
+    if (coin(5))
+    {
+        node->SetValue(random() % 2 ? "new & text" : "");
+    }
+    if (depth > 0)
+    {
+        int children = int(random() % 5);
+
+        for (int i = 0; i < children; ++i)
+        {
+            auto    child = Generate(random, perturb, depth - 1, ids);
+
+            if (!coin(4))
+            {
+                node->AppendChild(child);
+            }
+            if (coin(4))
+            {
+                std::mt19937    other(random());
+                int             other_ids = 1000;
+
+                node->AppendChild(Generate(other, nullptr, 1, other_ids));
+            }
+        }
+    }
+
+    return node;
+}
+
+void    TestClientApplies()
+{
+    int edits = 0;
+
+    for (unsigned seed = 0; seed < 2000; ++seed)
+    {
+        std::mt19937    random_from(seed);
+        std::mt19937    random_to(seed);
+        std::mt19937    perturb(seed * 7 + 1);
+        int             ids_from = 0;
+        int             ids_to = 0;
+        Document        from;
+        Document        to;
+
+        from.AppendChild(Get<Body>())->AppendChild(Generate(random_from, nullptr, 4, ids_from));
+        to.AppendChild(Get<Body>())->AppendChild(Generate(random_to, &perturb, 4, ids_to));
+
+        Patch   patch(from, to);
+        auto    json = JsonEdits(patch.ToJson());
+
+        CHECK(json.size() == patch.Edits().size());
+        edits += int(json.size());
+
+        for (const Layout &layout : {Layout(), Layout::Minified()})
+        {
+            auto    dom = ParseRoot(from.Get(layout));
+
+            Apply(dom, json);
+            if (!CHECK(Canonical(*dom) == Canonical(*ParseRoot(to.Get(layout)))))
+            {
+                std::cerr << "seed " << seed << ": " << patch.ToJson() << std::endl;
+                return;
+            }
+        }
+    }
+
+    CHECK(edits > 1000);
+}
+
+//----------------------------------------------------------------------------
+void    TestAttributes()
+{
+    // The browser keeps the first of repeated attributes.
+    auto    from = Get<Div>();
+    auto    to = Get<Div>();
+
+    from->AppendClass("a");
+    to->AppendClass("a").AppendClass("b");
+    CHECK(Patch(*from, *to).empty());
+    CHECK(Patch(*to, *from).empty());
+
+    auto    changed = Get<Div>();
+    changed->AppendClass("b");
+    CHECK(Patch(*to, *changed).ToJson() == R"([{"op":"set_attribute","path":[],"name":"class","value":"b"}])");
+
+    auto    none = Get<Div>();
+    CHECK(Patch(*to, *none).ToJson() == R"([{"op":"remove_attribute","path":[],"name":"class"}])");
+}
+
+void    TestIds()
+{
+    Document    from;
+    Document    to;
+    Document    duplicated;
+
+    for (Document *doc : {&from, &to, &duplicated})
+    {
+        auto    body = doc->AppendChild(Get<Body>());
+        auto    main = body->AppendChild(Get<Div>());
+
+        main->AppendId("main");
+        main->AppendChild(Get<Paragraph>(doc == &from ? "old" : "new"));
+        if (doc == &duplicated)
+        {
+            body->AppendChild(Get<Div>())->AppendId("main");
+        }
+    }
+
+    CHECK(Patch(from, to).ToJson() == R"([{"op":"set_text","id":"main","path":[0],"value":"new"}])");
+    // The new page has the id twice, so getElementById() is no longer safe for later patches.
+    const Patch to_duplicated(from, duplicated);
+    for (auto &e : to_duplicated.Edits())
+    {
+        CHECK(e.id.empty());
+    }
+}
+
+int main()
+{
+    TestAttributes();
+    TestIds();
+    TestClientApplies();
+
+    return Result();
+}
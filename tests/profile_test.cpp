@@ -0,0 +1,207 @@
+//----------------------------------------------------------------------------
+// Profiler: per-type statistics, nesting depth, frozen subtrees and the trace
+// callback. Compiled with SIMPLE_HTML_PROFILE.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/// A div holding a rows x columns table, a paragraph and an image: depth 4.
+std::shared_ptr<NodeBase>   Sample(int rows, int columns)
+{
+    auto    div = Get<Div>();
+    auto    table = div->AppendChild(Get<Table>());
+    for (int r = 0; r < rows; ++r)
+    {
+        auto    row = table->AppendChild(Get<TableRow>());
+        for (int c = 0; c < columns; ++c)
+        {
+            row->AppendChild(Get<TableElement>(std::to_string(r * columns + c)));
+        }
+    }
+    div->AppendChild(Get<Paragraph>("a & b"))->AppendChild(Get<Text>(" more"));
+    div->AppendChild(Get<Image>("a.png", "alt", 10, 20));
+
+    return div;
+}
+
+//----------------------------------------------------------------------------
+std::size_t NodesOf(const ProfileStats &stats)
+{
+    std::size_t nodes = 0;
+    for (const auto &type : stats.types)
+    {
+        nodes += type.second.nodes;
+    }
+
+    return nodes;
+}
+
+//----------------------------------------------------------------------------
+std::size_t BytesOf(const ProfileStats &stats)
+{
+    std::size_t bytes = 0;
+    for (const auto &type : stats.types)
+    {
+        bytes += type.second.bytes;
+    }
+
+    return bytes;
+}
+
+//----------------------------------------------------------------------------
+/// Every node is counted once under its type, and the bytes of all types add
+/// up to the output.
+void    TestTypes()
+{
+    auto    div = Sample(3, 4);
+
+    for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+    {
+        Profiler    profiler;
+        std::string output;
+        {
+            ProfileScope    scope(profiler);
+            output = div->Get(layout);
+        }
+
+        const ProfileStats  &stats = profiler.Stats();
+        CHECK(stats.nodes == 1 + 1 + 3 + 12 + 1 + 1 + 1);
+        CHECK(NodesOf(stats) == stats.nodes);
+        CHECK(stats.bytes == output.size());
+        CHECK(BytesOf(stats) == output.size());
+        CHECK(stats.types.at("Div").nodes == 1);
+        CHECK(stats.types.at("TableRow").nodes == 3);
+        CHECK(stats.types.at("TableElement").nodes == 12);
+        CHECK(stats.types.at("Image").nodes == 1);
+        CHECK(stats.types.at("Image").bytes == Get<Image>("a.png", "alt", 10, 20)->Get(layout).size());
+        CHECK(stats.max_depth == 4);
+    }
+
+    // Nothing is reported outside a scope.
+    Profiler    profiler;
+    div->Get();
+    CHECK(profiler.Stats().nodes == 0);
+    CHECK(profiler.Stats().types.empty());
+}
+
+//----------------------------------------------------------------------------
+/// max_depth is the deepest level written, the node serialized being level 1.
+void    TestMaxDepth()
+{
+    for (int depth : {1, 2, 10, 100})
+    {
+        auto    root = Get<Div>();
+        std::shared_ptr<NodeBase>   node = root;
+        for (int i = 1; i < depth; ++i)
+        {
+            node = node->AppendChild(Get<Div>());
+        }
+
+        Profiler    profiler;
+        {
+            ProfileScope    scope(profiler);
+            root->Get();
+        }
+        CHECK(profiler.Stats().max_depth == std::size_t(depth));
+        CHECK(profiler.Stats().nodes == std::size_t(depth));
+    }
+}
+
+//----------------------------------------------------------------------------
+/// A frozen subtree is written from its cache and counted as one node of its
+/// root type, holding the bytes of the whole subtree.
+void    TestFrozen()
+{
+    auto    shared = Sample(2, 2);
+    shared->Freeze();
+    const std::string   subtree = shared->Get(1);
+
+    auto    page = Get<Body>();
+    page->AppendChild(shared);
+    page->AppendChild(shared);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        Profiler    profiler;
+        std::string output;
+        {
+            ProfileScope    scope(profiler);
+            output = page->Get();
+        }
+
+        const ProfileStats  &stats = profiler.Stats();
+        CHECK(stats.nodes == 3);
+        CHECK(NodesOf(stats) == 3);
+        CHECK(stats.types.at("Div").nodes == 2);
+        CHECK(stats.types.at("Div").bytes == 2 * subtree.size());
+        CHECK(stats.types.count("TableElement") == 0);
+        CHECK(stats.bytes == output.size());
+        CHECK(BytesOf(stats) == output.size());
+        CHECK(stats.max_depth == 2);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// The trace callback sees every node once, children before their parents.
+void    TestTrace()
+{
+    auto    div = Sample(2, 3);
+
+    std::size_t events = 0;
+    std::size_t elements = 0;
+    std::size_t deepest = 0;
+    std::size_t last_depth = 0;
+    std::size_t last_bytes = 0;
+    std::string last_type;
+
+    ProfileOptions  options;
+    options.trace = [&](const TraceEvent &event)
+    {
+        ++events;
+        if (event.type == "TableElement")   ++elements;
+        deepest = std::max(deepest, event.depth);
+        last_depth = event.depth;
+        last_bytes = event.bytes;
+        last_type = event.type;
+    };
+
+    Profiler    profiler(options);
+    std::string output;
+    {
+        ProfileScope    scope(profiler);
+        output = div->Get();
+    }
+
+    CHECK(events == profiler.Stats().nodes);
+    CHECK(events == 1 + 1 + 2 + 6 + 1 + 1 + 1);
+    CHECK(elements == 6);
+    CHECK(deepest == 4);
+    CHECK(last_type == "Div");
+    CHECK(last_depth == 1);
+    CHECK(last_bytes == output.size());
+
+    // Reset() starts over.
+    profiler.Reset();
+    events = 0;
+    {
+        ProfileScope    scope(profiler);
+        div->Get();
+    }
+    CHECK(events == profiler.Stats().nodes);
+    CHECK(profiler.Stats().bytes == output.size());
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    TestTypes();
+    TestMaxDepth();
+    TestFrozen();
+    TestTrace();
+
+    return Result();
+}
@@ -0,0 +1,119 @@
+//----------------------------------------------------------------------------
+// Sinks: StringSink, StreamSink and BufferSink write the same bytes as Get().
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+#include <sstream>
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/// A list of rows items with escaped text, larger than the StreamSink buffer.
+std::shared_ptr<NodeBase>   Sample(int rows)
+{
+    auto    div = Get<Div>();
+    div->AppendClass("list");
+
+    auto    ul = div->AppendChild(Get<UnorderedList>());
+    for (int i = 0; i < rows; ++i)
+    {
+        ul->AppendChild(Get<ListItem>("item " + std::to_string(i) + " <&>"))->AppendChild(Get<Span>("x"));
+    }
+
+    return div;
+}
+
+//----------------------------------------------------------------------------
+void    TestStringSink()
+{
+    auto    div = Sample(500);
+
+    for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+    {
+        // Appended to what the string already holds.
+        std::string result = "prefix";
+        {
+            StringSink  sink(result);
+            sink.SetLayout(layout);
+            div->Write(sink, 1);
+            sink.Flush();
+            CHECK(sink.Size() == div->Get(layout, 1).size());
+        }
+        CHECK(result == "prefix" + div->Get(layout, 1));
+    }
+}
+
+//----------------------------------------------------------------------------
+void    TestStreamSink()
+{
+    for (int rows : {0, 1, 500})
+    {
+        auto    div = Sample(rows);
+
+        for (const Layout &layout : {Layout(), Layout::Minified()})
+        {
+            std::ostringstream  stream;
+            {
+                StreamSink  sink(stream);
+                sink.SetLayout(layout);
+                div->Write(sink);
+                CHECK(sink.Size() == div->Get(layout).size());
+            }
+            CHECK(stream.str() == div->Get(layout));
+        }
+
+        std::ostringstream  stream;
+        stream << *div;
+        CHECK(stream.str() == div->Get());
+    }
+
+    // A single write larger than the buffer goes to the stream directly.
+    auto    p = Get<Paragraph>(std::string(10000, 'x'));
+    std::ostringstream  stream;
+    stream << *p;
+    CHECK(stream.str() == p->Get());
+}
+
+//----------------------------------------------------------------------------
+void    TestBufferSink()
+{
+    auto    div = Sample(50);
+
+    for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+    {
+        const std::string   expected = div->Get(layout);
+        std::vector<char>   buffer(expected.size() + 16, '#');
+
+        BufferSink  sink(buffer.data(), expected.size());
+        sink.SetLayout(layout);
+        div->Write(sink);
+        CHECK(sink.Size() == expected.size());
+        CHECK(std::string(buffer.data(), expected.size()) == expected);
+        CHECK(buffer[expected.size()] == '#');
+
+        // One byte short.
+        bool    threw = false;
+        try
+        {
+            div->Render(buffer.data(), expected.size() - 1, 0, layout);
+        }
+        catch (const std::length_error&)
+        {
+            threw = true;
+        }
+        CHECK(threw);
+        CHECK(buffer[expected.size()] == '#');
+    }
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    TestStringSink();
+    TestStreamSink();
+    TestBufferSink();
+
+    return Result();
+}
@@ -0,0 +1,140 @@
+//----------------------------------------------------------------------------
+// SerializedSize() and GetPresized(): the computed size matches what Get()
+// writes, for every element type, escaped text and numeric attributes.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/// Every node appended by Sample(), to check each on its own too.
+std::vector<std::shared_ptr<NodeBase>>  nodes;
+
+std::shared_ptr<NodeBase>   Add(const std::shared_ptr<NodeBase> &parent, const std::shared_ptr<NodeBase> &child)
+{
+    nodes.push_back(parent->AppendChild(child));
+    return nodes.back();
+}
+
+//----------------------------------------------------------------------------
+/// A document with every element type, text that needs escaping and
+/// integer and floating point attributes.
+std::shared_ptr<Document>   Sample()
+{
+    auto    doc = Get<Document>();
+
+    auto    head = Add(doc, Get<Head>());
+    Add(head, Get<Title>("Sizes & \"quotes\""));
+    Add(head, Get<CSSResourceLink>("stylesheet", "style.css?a=1&b=2"));
+    Add(head, Get<ResourceLink>("icon"))->AppendAttribute("href", "icon.png");
+
+    auto    body = Add(doc, Get<Body>());
+    body->AppendId("top").AppendClass("page").AppendClass("wide");
+    for (int level = 1; level <= 6; ++level)
+    {
+        Add(body, Get<Heading>("Heading <" + std::to_string(level) + ">", level));
+    }
+
+    auto    p = Add(body, Get<Paragraph>("a < b & c > d"));
+    Add(p, Get<Text>(" 'single' \"double\""));
+    Add(p, Get<RawText>("<b>raw</b>"));
+    Add(p, Get<Span>("span"))->AppendAttribute("data-n", -42);
+    Add(p, Get<SubScript>("2"));
+    Add(p, Get<SuperScript>("n"));
+    Add(p, Get<Link>("https://example.com/?q=a&r=\"b\"", "link & text"));
+    Add(p, Get<Break>());
+    Add(p, Get<Span>());
+
+    Add(body, Get<Image>("a.png", "alt \"text\"", 640, 480));
+    Add(body, Get<Image>("b.png", "old", 1, 2, true));
+
+    auto    div = Add(body, Get<Div>());
+    div->AppendAttribute("data-ratio", 1.0 / 3);
+    div->AppendAttribute("data-fixed", 2.5, NumberFormat{3});
+    div->AppendAttribute("data-big", std::int64_t(-9007199254740993));
+    div->AppendAttribute("data-size", std::size_t(18446744073709551615u));
+    Add(div, Get<Div>());
+
+    auto    ul = Add(body, Get<UnorderedList>());
+    Add(ul, Get<ListItem>("one"));
+    Add(Add(ul, Get<ListItem>()), Get<Paragraph>("nested"));
+    auto    ol = Add(body, Get<OrderedList>());
+    Add(ol, Get<ListItem>("two & three"));
+
+    auto    table = Add(body, Get<Table>("Caption <1>"));
+    auto    header = Add(table, Get<TableRow>());
+    Add(header, Get<TableHeaderElement>("Name"));
+    Add(header, Get<TableHeaderElement>());
+    auto    row = Add(table, Get<TableRow>());
+    Add(row, Get<TableElement>("x & y"));
+    Add(Add(row, Get<TableElement>()), Get<Span>("in cell"));
+    Add(body, Get<Table>());
+
+    auto    columns = Get<ColumnTable>();
+    columns->AppendColumn("Name", std::vector<std::string_view>{"a<b", "c&d", ""}, "name");
+    columns->AppendColumn("Count", std::vector<std::int64_t>{0, -1, 1234567}, "number");
+    columns->AppendColumn("", std::vector<double>{0.1, -2.5, 1e300}, NumberFormat{2});
+    Add(body, columns);
+
+    Add(body, Get<Element<tags::div>>("element"));
+    Add(body, Get<Element<tags::td, NodeLine>>("element line"));
+    Add(body, Get<Element<tags::span, NodeInline>>("element inline"));
+    Add(body, Get<Element<tags::br, Void>>());
+    Add(body, GetNodeInline("em", "custom & inline"));
+
+    return doc;
+}
+
+//----------------------------------------------------------------------------
+void    Check(NodeBase &node)
+{
+    for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+    {
+        for (int indentation : {0, 1, 4})
+        {
+            CHECK(node.SerializedSize(layout, indentation) == node.Get(layout, indentation).size());
+            CHECK(node.GetPresized(indentation, layout) == node.Get(layout, indentation));
+        }
+    }
+
+    CHECK(node.SerializedSize() == node.Get().size());
+    CHECK(node.GetPresized() == node.Get());
+}
+
+//----------------------------------------------------------------------------
+/// The whole document, and every element type on its own.
+void    TestElements()
+{
+    auto    doc = Sample();
+    Check(*doc);
+
+    for (auto &node : nodes)
+    {
+        Check(*node);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Frozen subtrees are counted from their cached output.
+void    TestFrozen()
+{
+    auto    shared = Get<Paragraph>("shared & frozen");
+    shared->AppendChild(Get<Span>("inline"));
+    shared->Freeze();
+
+    auto    div = Get<Div>();
+    div->AppendChild(shared);
+    div->AppendChild(Get<Div>())->AppendChild(shared);
+    Check(*div);
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    TestElements();
+    TestFrozen();
+
+    return Result();
+}
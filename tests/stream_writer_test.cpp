@@ -0,0 +1,149 @@
+//----------------------------------------------------------------------------
+// StreamWriter: nodes opened, appended and closed in document order write
+// the same bytes as the tree built in memory.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+#include <sstream>
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/// Open, Append and Close nest like the tree they stream.
+void    TestNesting()
+{
+    auto    expected = Get<Body>();
+    expected->AppendChild(Get<Heading>("Title", 1));
+    auto    div = expected->AppendChild(Get<Div>());
+    div->AppendClass("box");
+    div->AppendChild(Get<Paragraph>("first & last"));
+    auto    ul = div->AppendChild(Get<UnorderedList>());
+    ul->AppendChild(Get<ListItem>("one"));
+    ul->AppendChild(Get<ListItem>("two"));
+    div->AppendChild(Get<Span>("inline"));
+    expected->AppendChild(Get<Paragraph>("after"));
+
+    for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+    {
+        std::string result;
+        {
+            StringSink      sink(result);
+            sink.SetLayout(layout);
+            StreamWriter    writer(sink, 1);
+
+            auto    body = writer.Open(Get<Body>());
+            writer.Append(Get<Heading>("Title", 1));
+            {
+                auto    box = Get<Div>();
+                box->AppendClass("box");
+                auto    scope = writer.Open(box);
+                CHECK(writer.Depth() == 2);
+
+                writer.Append(Get<Paragraph>("first & last"));
+                {
+                    // Closed by hand; the scope then has nothing left to close.
+                    auto    list = writer.Open(Get<UnorderedList>());
+                    writer.Append(Get<ListItem>("one"));
+                    writer.Append(Get<ListItem>("two"));
+                    writer.Close();
+                    CHECK(writer.Depth() == 2);
+                }
+                CHECK(writer.Depth() == 2);
+                writer.Append(Get<Span>("inline"));
+            }
+            CHECK(writer.Depth() == 1);
+            writer.Append(Get<Paragraph>("after"));
+            body.Close();
+            CHECK(writer.Depth() == 0);
+            sink.Flush();
+        }
+        CHECK(result == expected->Get(layout, 1));
+    }
+
+    // Children the opened node already has are written first.
+    std::ostringstream  stream;
+    {
+        StreamSink      sink(stream);
+        StreamWriter    writer(sink);
+
+        auto    open = Get<Div>();
+        open->AppendChild(Get<Paragraph>("existing"));
+        auto    scope = writer.Open(open);
+        writer.Append(Get<Paragraph>("streamed"));
+    }
+
+    auto    both = Get<Div>();
+    both->AppendChild(Get<Paragraph>("existing"));
+    both->AppendChild(Get<Paragraph>("streamed"));
+    CHECK(stream.str() == both->Get());
+}
+
+//----------------------------------------------------------------------------
+/// Closing with nothing open and opening a node without children throw.
+void    TestErrors()
+{
+    std::string     result;
+    StringSink      sink(result);
+    StreamWriter    writer(sink);
+
+    bool    threw = false;
+    try {writer.Close();} catch (const std::logic_error&) {threw = true;}
+    CHECK(threw);
+
+    {
+        auto    div = writer.Open(Get<Div>());
+        writer.Close();
+        CHECK(writer.Depth() == 0);
+
+        // One close too many.
+        threw = false;
+        try {writer.Close();} catch (const std::logic_error&) {threw = true;}
+        CHECK(threw);
+    }
+
+    threw = false;
+    try {writer.Open(Get<Text>("text"));} catch (const std::logic_error&) {threw = true;}
+    CHECK(threw);
+
+    threw = false;
+    try {writer.Open(Get<Image>("a.png", "alt", 1, 1));} catch (const std::logic_error&) {threw = true;}
+    CHECK(threw);
+    CHECK(writer.Depth() == 0);
+
+    sink.Flush();
+    CHECK(result == "<div>\n</div>");
+}
+
+//----------------------------------------------------------------------------
+/// An exception unwinding an open scope leaves its end tag unwritten.
+void    TestUnwinding()
+{
+    std::string     result;
+    StringSink      sink(result);
+    StreamWriter    writer(sink);
+
+    try
+    {
+        auto    div = writer.Open(Get<Div>());
+        throw std::runtime_error("failed");
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+
+    sink.Flush();
+    CHECK(result == "<div>");
+    CHECK(writer.Depth() == 1);
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    TestNesting();
+    TestErrors();
+    TestUnwinding();
+
+    return Result();
+}
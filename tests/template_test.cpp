@@ -0,0 +1,84 @@
+//----------------------------------------------------------------------------
+// Template::Render() against Get() on the tree built with the slot values in
+// place of the slots.
+//----------------------------------------------------------------------------
+#include "simple_html_writer.h"
+
+#include "check.h"
+
+using namespace simple_html;
+
+//----------------------------------------------------------------------------
+/// A page with content in front of, in place of (if fill is set) and after the slot.
+std::shared_ptr<Document>   Page(const std::shared_ptr<NodeBase> &fill)
+{
+    auto    doc = Get<Document>();
+    auto    body = doc->AppendChild(Get<Body>());
+    auto    paragraph = body->AppendChild(Get<Paragraph>("before"));
+
+    if (fill)
+    {
+        body->AppendChild(fill);
+    }
+    body->AppendChild(Get<Paragraph>("after"));
+    paragraph->AppendChild(Get<Span>("inline"));
+
+    return doc;
+}
+
+/// Renders Page() with a slot and compares it with the literal page for every layout.
+void    CheckSlot(Sink::SlotKind kind, const TemplateValues &values, const std::shared_ptr<NodeBase> &literal)
+{
+    auto    with_slot = Page(Get<Slot>("content", kind));
+    auto    expected = Page(literal);
+
+    for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+    {
+        const Template  page(*with_slot, 0, layout);
+
+        CHECK(page.Render(values) == expected->Get(layout));
+    }
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // Empty slots render as nothing.
+    CheckSlot(Sink::NodeSlot, TemplateValues(), nullptr);
+    CheckSlot(Sink::TextSlot, TemplateValues(), nullptr);
+
+    // Text goes inline, in a text slot or a node slot.
+    CheckSlot(Sink::TextSlot, TemplateValues().Set("content", "a < b"), Get<Text>("a < b"));
+    CheckSlot(Sink::NodeSlot, TemplateValues().Set("content", "a < b"), Get<Text>("a < b"));
+
+    // Nodes are placed like any other child, block or inline.
+    auto    table = Get<Table>();
+    table->AppendChild(Get<TableRow>())->AppendChild(Get<TableElement>("1"));
+    CheckSlot(Sink::NodeSlot, TemplateValues().Set("content", table), table);
+
+    auto    link = Get<Link>("https://example.com", "example");
+    CheckSlot(Sink::NodeSlot, TemplateValues().Set("content", link), link);
+
+    // A slot is placed by the parent it is written under, not the one it was first appended to.
+    auto    slot = Get<Slot>("content");
+    auto    span = Get<Span>();
+    span->AppendChild(slot);
+
+    auto    with_slot = Page(slot);
+    auto    with_text = Page(Get<Text>("text"));
+    auto    with_table = Page(table);
+    for (const Layout &layout : {Layout(), Layout::Minified(), Layout::Spaces(2)})
+    {
+        CHECK(Template(*with_slot, 0, layout).Render(TemplateValues().Set("content", "text")) == with_text->Get(layout));
+        CHECK(Template(*with_slot, 0, layout).Render(TemplateValues().Set("content", table)) == with_table->Get(layout));
+    }
+
+    auto    block_first = Get<Slot>("content");
+    auto    div = Get<Div>();
+    auto    inline_parent = Get<Span>();
+    div->AppendChild(block_first);
+    inline_parent->AppendChild(block_first);
+    CHECK(Template(*inline_parent).Render(TemplateValues().Set("content", "text")) == "<span>text</span>");
+
+    return Result();
+}